@@ -37,6 +37,11 @@ void AI::onEvent(const Event& event)
   */
 }
 
+EventMask AI::getEventMask() const
+{
+  return EVENTMASK_ALL;
+}
+
 bool AI::boastCards(const Info& info)
 {
   (void)info;
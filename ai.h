@@ -23,8 +23,8 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include "action.h"
+#include "event.h"
 
-struct Event;
 struct Info;
 
 class AI //interface class, used for bots, but also for human players (then the AI uses human input instead of calculating itself)
@@ -45,6 +45,15 @@ class AI //interface class, used for bots, but also for human players (then the
     */
     virtual void onEvent(const Event& event);
 
+    /*
+    getEventMask:
+    which types of events onEvent wants to get (see eventMask in event.h), e.g.
+    eventMask(E_FLOP) | eventMask(E_WIN). The others aren't sent, which makes the game faster.
+    By default the AI gets all events. An AI that doesn't use onEvent at all can return 0.
+    This is asked once when the AI sits down at the table, so it should always return the same.
+    */
+    virtual EventMask getEventMask() const;
+
     /*
     boastCards:
     called at the end of a deal, only if this AI wasn't required to show his cards.
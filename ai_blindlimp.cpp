@@ -39,3 +39,8 @@ std::string AIBlindLimp::getAIName()
 {
   return "BlindLimp";
 }
+
+EventMask AIBlindLimp::getEventMask() const
+{
+  return 0;
+}
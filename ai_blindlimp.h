@@ -34,4 +34,6 @@ class AIBlindLimp: public AI
     virtual Action doTurn(const Info& info);
 
     virtual std::string getAIName();
+
+    virtual EventMask getEventMask() const; //this AI doesn't use events
 };
@@ -33,3 +33,8 @@ std::string AICall::getAIName()
 {
   return "Call";
 }
+
+EventMask AICall::getEventMask() const
+{
+  return 0;
+}
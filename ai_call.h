@@ -32,4 +32,6 @@ class AICall : public AI
     virtual Action doTurn(const Info& info);
 
     virtual std::string getAIName();
+
+    virtual EventMask getEventMask() const; //this AI doesn't use events
 };
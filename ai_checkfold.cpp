@@ -36,3 +36,8 @@ std::string AICheckFold::getAIName()
 {
   return "CheckFold";
 }
+
+EventMask AICheckFold::getEventMask() const
+{
+  return 0;
+}
@@ -37,3 +37,8 @@ std::string AIRaise::getAIName()
 {
   return "Raise";
 }
+
+EventMask AIRaise::getEventMask() const
+{
+  return 0;
+}
@@ -33,4 +33,6 @@ class AIRaise : public AI
     virtual Action doTurn(const Info& info);
 
     virtual std::string getAIName();
+
+    virtual EventMask getEventMask() const; //this AI doesn't use events
 };
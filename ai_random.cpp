@@ -59,3 +59,8 @@ std::string AIRandom::getAIName()
 {
   return "Random";
 }
+
+EventMask AIRandom::getEventMask() const
+{
+  return 0;
+}
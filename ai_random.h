@@ -33,4 +33,6 @@ class AIRandom : public AI
     virtual bool boastCards(const Info& info);
 
     virtual std::string getAIName();
+
+    virtual EventMask getEventMask() const; //this AI doesn't use events
 };
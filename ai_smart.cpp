@@ -88,9 +88,7 @@ Action AISmart::doTurn(const Info& info)
   {
     double win, tie, lose;
     int num_opponents = info.getNumActivePlayers() - 1;
-    if(info.round == R_FLOP) getWinChanceAgainstNAtFlop(win, tie, lose, info.getHoleCards()[0], info.getHoleCards()[1], info.boardCards[0], info.boardCards[1], info.boardCards[2], num_opponents);
-    else if(info.round == R_TURN) getWinChanceAgainstNAtTurn(win, tie, lose, info.getHoleCards()[0], info.getHoleCards()[1], info.boardCards[0], info.boardCards[1], info.boardCards[2], info.boardCards[3], num_opponents);
-    else if(info.round == R_RIVER) getWinChanceAgainstNAtRiver(win, tie, lose, info.getHoleCards()[0], info.getHoleCards()[1], info.boardCards[0], info.boardCards[1], info.boardCards[2], info.boardCards[3], info.boardCards[4], num_opponents);
+    getWinChanceAgainstNCached(win, tie, lose, info.getHoleCards(), info.boardCards, num_opponents); //cached: all AISmart players at the table often ask the same
 
     if(win > tightness)
     {
@@ -153,3 +151,8 @@ std::string AISmart::getAIName()
 {
   return "Smart";
 }
+
+EventMask AISmart::getEventMask() const
+{
+  return 0;
+}
@@ -36,5 +36,7 @@ class AISmart : public AI
     virtual Action doTurn(const Info& info);
 
     virtual std::string getAIName();
+
+    virtual EventMask getEventMask() const; //this AI doesn't use events
 };
 
@@ -219,12 +219,6 @@ Card::Card(const std::string& shortName) //e.g. "Qs"
   setShortName(shortName);
 }
 
-Card::Card(const Card& other)
-: suit(other.suit)
-, value(other.value)
-{
-}
-
 int Card::getIndex() const
 {
   return valueAndSuitToIndex(value, suit);
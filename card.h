@@ -57,7 +57,6 @@ class Card
     Card(int index);
     Card(); //makes invalid card
     Card(const std::string& shortName); //e.g. "Qs"
-    Card(const Card& other);
 
     int getValue() const; //returns 2 for 2, up to 14 for ace
     void setValue(int value); //value must be 2-14, for ace use 14
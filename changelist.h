@@ -1,6 +1,18 @@
 /*
 OOPoker Changelist
 
+20261019:
+
+Incompatible interface changes:
+
+-the Event struct is now a plain fixed size struct without strings, so that creating and sending
+ events doesn't allocate memory. The player is given as an id (Event::playerId) instead of a name;
+ use event.getPlayer() instead of event.player, event.getAI() instead of event.ai and
+ event.getMessage() instead of event.message. The strings are in the EventStrings of the Game.
+-the Event constructors take a player id instead of a player name, and the constructors for
+ E_TOURNAMENT_RANK, E_REVEAL_AI and the message events are removed (set the fields instead).
+-Player::getName() returns a const reference
+
 20100513:
 
 -added combinatorial mathematics functions in pokermath.h: such as factorial and binomial coefficient (combination)
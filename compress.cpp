@@ -0,0 +1,155 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "compress.h"
+
+#include <cstring>
+#include <stdint.h>
+
+static const int MIN_MATCH = 4;
+static const int HASH_BITS = 14;
+static const size_t MAX_OFFSET = 65535;
+
+static uint32_t read32(const unsigned char* p)
+{
+  uint32_t result;
+  std::memcpy(&result, p, 4);
+  return result;
+}
+
+static uint32_t hash4(uint32_t value)
+{
+  return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+//the 255, 255, ..., rest bytes for a length of at least 15
+static void writeLength(unsigned char*& op, size_t length)
+{
+  length -= 15;
+  while(length >= 255)
+  {
+    *op++ = 255;
+    length -= 255;
+  }
+  *op++ = (unsigned char)length;
+}
+
+static void writeSequence(unsigned char*& op, const unsigned char* literals, size_t numLiterals, size_t offset, size_t matchLength)
+{
+  size_t m = matchLength ? matchLength - MIN_MATCH : 0;
+  *op++ = (unsigned char)(((numLiterals < 15 ? numLiterals : 15) << 4) | (m < 15 ? m : 15));
+  if(numLiterals >= 15) writeLength(op, numLiterals);
+  std::memcpy(op, literals, numLiterals);
+  op += numLiterals;
+  if(matchLength == 0) return; //the last sequence
+  *op++ = (unsigned char)(offset & 255);
+  *op++ = (unsigned char)(offset >> 8);
+  if(m >= 15) writeLength(op, m);
+}
+
+size_t compressBound(size_t size)
+{
+  return size + size / 255 + 16;
+}
+
+size_t compressBlock(std::vector<unsigned char>& out, const unsigned char* in, size_t size)
+{
+  size_t begin = out.size();
+  out.resize(begin + compressBound(size));
+  unsigned char* op = &out[begin];
+
+  int table[1 << HASH_BITS]; //last position where each hash of 4 bytes was seen
+  for(int i = 0; i < (1 << HASH_BITS); i++) table[i] = -1;
+
+  size_t anchor = 0; //start of the literals not yet written
+  size_t i = 0;
+  while(i + MIN_MATCH <= size)
+  {
+    uint32_t value = read32(in + i);
+    uint32_t h = hash4(value);
+    int candidate = table[h];
+    table[h] = (int)i;
+
+    if(candidate >= 0 && i - candidate <= MAX_OFFSET && read32(in + candidate) == value)
+    {
+      size_t length = MIN_MATCH;
+      while(i + length < size && in[candidate + length] == in[i + length]) length++;
+      writeSequence(op, in + anchor, i - anchor, i - candidate, length);
+      i += length;
+      anchor = i;
+    }
+    else i++;
+  }
+  writeSequence(op, in + anchor, size - anchor, 0, 0);
+
+  size_t packed = op - &out[begin];
+  out.resize(begin + packed);
+  return packed;
+}
+
+//reads the extra bytes of a length that was 15 in the token. Returns false if the input ends first.
+static bool readLength(size_t& length, const unsigned char*& ip, const unsigned char* end)
+{
+  for(;;)
+  {
+    if(ip >= end) return false;
+    unsigned char b = *ip++;
+    length += b;
+    if(b < 255) return true;
+  }
+}
+
+bool decompressBlock(unsigned char* out, size_t outSize, const unsigned char* in, size_t inSize)
+{
+  const unsigned char* ip = in;
+  const unsigned char* end = in + inSize;
+  size_t o = 0;
+
+  while(ip < end)
+  {
+    unsigned char token = *ip++;
+
+    size_t numLiterals = token >> 4;
+    if(numLiterals == 15 && !readLength(numLiterals, ip, end)) return false;
+    if(numLiterals > (size_t)(end - ip) || numLiterals > outSize - o) return false;
+    std::memcpy(out + o, ip, numLiterals);
+    ip += numLiterals;
+    o += numLiterals;
+
+    if(ip == end) break; //the last sequence has no match
+
+    if(end - ip < 2) return false;
+    size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    size_t length = token & 15;
+    if(length == 15 && !readLength(length, ip, end)) return false;
+    length += MIN_MATCH;
+    if(offset == 0 || offset > o || length > outSize - o) return false;
+
+    //byte per byte, because the match can overlap with what it's writing (e.g. offset 1 repeats one byte)
+    const unsigned char* match = out + o - offset;
+    for(size_t j = 0; j < length; j++) out[o + j] = match[j];
+    o += length;
+  }
+
+  return o == outSize;
+}
@@ -0,0 +1,52 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+/*
+A small and fast block compression codec (in the style of LZ4: byte oriented, no entropy coding),
+used for the compressed logs of ObserverLog. It's made for speed, not for the best ratio: the text logs
+become about 4 times smaller, at hundreds of MB per second.
+
+A compressed block is a series of sequences. Each sequence starts with a token byte: the high 4
+bits are the amount of literal bytes, the low 4 bits the match length minus 4. A value of 15 means
+more bytes follow, that are added to it until one is smaller than 255. Then come the literal bytes,
+and then the offset of the match (2 bytes, little endian, 1-65535 bytes back in the output). The last
+sequence of a block only has literals, it ends where the input ends.
+*/
+
+#include <cstddef>
+#include <vector>
+
+//the maximum compressed size of size bytes of input (incompressible data becomes slightly bigger)
+size_t compressBound(size_t size);
+
+//compresses size bytes of in, and appends the result to out. Returns the compressed size.
+size_t compressBlock(std::vector<unsigned char>& out, const unsigned char* in, size_t size);
+
+/*
+Decompresses a block made by compressBlock. outSize must be exactly the original size (the
+block doesn't store it itself). Returns false if the data is corrupt, it never reads or writes
+outside of the given buffers.
+*/
+bool decompressBlock(unsigned char* out, size_t outSize, const unsigned char* in, size_t inSize);
@@ -23,34 +23,159 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #include "deck.h"
 #include "random.h"
 
-Deck::Deck()
+#include <algorithm>
+
+Deck::Deck(RandomStream* random)
 : index(0)
+, size(52)
+, ordered(false)
+, random(random)
 {
-  for(size_t i = 0; i < 52; i++) cards[i].setIndex(i);
+  for(int i = 0; i < 52; i++) cards[i] = i;
 }
 
-void Deck::shuffle()
+void Deck::setRandom(RandomStream* random)
 {
-  index = 0;
+  this->random = random;
+}
 
-  Card old[52];
-  for(size_t i = 0; i < 52; i++) old[i] = cards[i];
+void Deck::setCards(const int* cards, int num)
+{
+  for(int i = 0; i < num; i++) this->cards[i] = cards[i];
+  index = 0;
+  size = num;
+  ordered = false;
+}
 
-  //Fisher-Yates shuffle
-  for(size_t i = 0; i < 52; i++)
+void Deck::shuffle()
+{
+  //the dealt cards are put back in the reverse order of dealing, that gives the order from before the dealing again
+  while(index > 0)
   {
-    int r = (int)(getRandom() * (52 - i));
-    cards[i] = old[r];
-    std::swap(old[r], old[(52 - 1 - i)]);
+    index--;
+    std::swap(cards[index], cards[swapped[index]]);
+  }
+  ordered = false;
+}
 
+bool Deck::remove(int card)
+{
+  shuffle(); //the removal changes the order of the cards in the deck, after that the dealing can't be undone anymore
+  for(int i = index; i < size; i++)
+  {
+    if(cards[i] == card)
+    {
+      size--;
+      std::swap(cards[i], cards[size]);
+      return true;
+    }
   }
+  return false;
+}
+
+bool Deck::remove(const Card& card)
+{
+  return remove(card.getIndex());
 }
 
 Card Deck::next()
 {
-  if(index >= 52) return Card();
+  if(index >= size) return Card();
+
+  if(random) return Card(nextIndex(*random));
 
-  Card result = cards[index];
-  index++;
-  return result;
+  RandomSlow slow;
+  return Card(nextIndex(slow));
+}
+
+int Deck::getNumLeft() const
+{
+  return size - index;
+}
+
+const int* Deck::getDealt() const
+{
+  return cards;
 }
+
+void Deck::getOrder(int order[52]) const
+{
+  for(int i = 0; i < 52; i++) order[i] = cards[i];
+}
+
+void Deck::setOrder(const int order[52])
+{
+  for(int i = 0; i < 52; i++) cards[i] = order[i];
+  index = 0;
+  size = 52;
+  ordered = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static const char DECK_FILE_MAGIC[8] = { 'O', 'O', 'P', 'D', 'E', 'C', 'K', '1' };
+static const int DECK_RECORD_SIZE = 39; //52 cards of 6 bits
+
+DeckWriter::DeckWriter(const std::string& filename)
+: file(filename.c_str(), std::ios::out|std::ios::binary)
+{
+  if(file) file.write(DECK_FILE_MAGIC, 8);
+}
+
+bool DeckWriter::isOpen() const
+{
+  return file.good();
+}
+
+void DeckWriter::write(const Deck& deck)
+{
+  int order[52];
+  deck.getOrder(order);
+
+  //4 cards of 6 bits in every 3 bytes
+  unsigned char record[DECK_RECORD_SIZE];
+  for(int i = 0; i < 13; i++)
+  {
+    unsigned long v = (order[i * 4 + 0] << 18) | (order[i * 4 + 1] << 12) | (order[i * 4 + 2] << 6) | order[i * 4 + 3];
+    record[i * 3 + 0] = (unsigned char)(v >> 16);
+    record[i * 3 + 1] = (unsigned char)(v >> 8);
+    record[i * 3 + 2] = (unsigned char)v;
+  }
+  file.write((const char*)record, DECK_RECORD_SIZE);
+}
+
+DeckReader::DeckReader(const std::string& filename)
+: file(filename.c_str(), std::ios::in|std::ios::binary)
+{
+  char magic[8];
+  if(file.read(magic, 8) && std::equal(magic, magic + 8, DECK_FILE_MAGIC)) return;
+  file.setstate(std::ios::failbit);
+}
+
+bool DeckReader::isOpen() const
+{
+  return file.good();
+}
+
+bool DeckReader::read(Deck& deck)
+{
+  unsigned char record[DECK_RECORD_SIZE];
+  if(!file.read((char*)record, DECK_RECORD_SIZE)) return false;
+
+  int order[52];
+  bool used[52] = { false };
+  for(int i = 0; i < 13; i++)
+  {
+    unsigned long v = (record[i * 3 + 0] << 16) | (record[i * 3 + 1] << 8) | record[i * 3 + 2];
+    for(int j = 0; j < 4; j++)
+    {
+      int card = (v >> (18 - 6 * j)) & 63;
+      if(card >= 52 || used[card]) return false; //corrupt file, not a permutation of the 52 cards
+      used[card] = true;
+      order[i * 4 + j] = card;
+    }
+  }
+
+  deck.setOrder(order);
+  return true;
+}
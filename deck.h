@@ -23,23 +23,115 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include "card.h"
+#include "random.h"
+
+#include <fstream>
+#include <string>
 
 
 class Deck
 {
   /*
-  Deck of cards, that can be randomly shuffled using the true random.h, and
-  allows easily selecting next cards.
+  Deck of cards, that is shuffled lazily: shuffling only puts the dealt cards back, and each
+  next card is drawn at random from the cards still in the deck at the moment it's needed.
+  So dealing a card is O(1), shuffling costs as much as the cards that were dealt, and only the
+  cards that are really dealt cost time (a deal in the Game draws its cards round by round, at
+  most 27 of the 52 with the burned cards, and most deals end before the river).
+
+  Shuffling puts the dealt cards back exactly where they were, so the cards of a deal depend only
+  on the random numbers of that deal, not on how many cards the deals before it used.
+
+  The random numbers come from the RandomStream given to the constructor or setRandom, or from
+  getRandomUint if none is given. The templated nextIndex can use any other random generator
+  with a getUint function instead, e.g. RandomFast for monte carlo simulations.
+
+  The cards are integers 0-51. For next() that is the Card::getIndex numbering, but a deck made
+  with setCards can hold any set of cards in any numbering, e.g. the eval7_index values of the
+  cards that aren't known yet.
   */
 
   private:
 
-    Card cards[52]; //card 0 is the top card
+    int cards[52]; //cards[0 .. index[ are dealt, in dealing order. cards[index .. size[ are still in the deck, in no particular order.
+    unsigned char swapped[52]; //swapped[i]: where the card dealt as i came from, to undo the dealing when shuffling
     int index;
+    int size; //removed (dead) cards are moved behind size
+    bool ordered; //if true, the cards are dealt in the order of cards[] instead of at random (see setOrder)
+    RandomStream* random;
 
   public:
 
-    Deck();
-    void shuffle();
-    Card next(); //never call this more than 52 times in a row.
+    Deck(RandomStream* random = 0); //all 52 cards
+    void setRandom(RandomStream* random); //null to use getRandomUint
+
+    void setCards(const int* cards, int num); //makes this a deck of only the given cards
+    void shuffle(); //puts the dealt cards back in the deck. Removed cards stay out of it.
+    bool remove(int card); //dead card: takes this card out of the deck, until the next setCards. Puts the dealt cards back first. Returns false if it isn't in the deck (anymore).
+    bool remove(const Card& card);
+
+    Card next(); //returns an invalid card if no more cards are left.
+
+    //draws the next card with the given random generator. Never call this when getNumLeft() is 0.
+    template<typename Random>
+    int nextIndex(Random& random)
+    {
+      if(!ordered)
+      {
+        int r = index + getRandomBounded(random, size - index);
+        int temp = cards[r];
+        cards[r] = cards[index];
+        cards[index] = temp;
+        swapped[index] = (unsigned char)r;
+      }
+      else swapped[index] = (unsigned char)index;
+      return cards[index++];
+    }
+
+    //deals the card at offset r (0 to getNumLeft() - 1) of the cards left, for random numbers that are drawn in bulk (see RandomLanes::fillBounded)
+    int nextIndexAt(int r)
+    {
+      r += index;
+      int temp = cards[r];
+      cards[r] = cards[index];
+      cards[index] = temp;
+      swapped[index] = (unsigned char)r;
+      return cards[index++];
+    }
+
+    int getNumLeft() const;
+    const int* getDealt() const; //the dealt cards since the last shuffle, in the order they were dealt
+
+    /*
+    The order of the cards, as card indices (see Card::getIndex): first the dealt cards in the order
+    they were dealt, then the rest. Setting it makes the deck deal in exactly that order, until the
+    next shuffle.
+    */
+    void getOrder(int order[52]) const;
+    void setOrder(const int order[52]);
 };
+
+/*
+Recording the card order of each deal to a file, to deal exactly the same cards again later.
+The file starts with "OOPDECK1", followed by 39 bytes per deal: the 52 card indices of 6 bits each.
+*/
+class DeckWriter
+{
+  private:
+    std::ofstream file;
+
+  public:
+    DeckWriter(const std::string& filename);
+    bool isOpen() const;
+    void write(const Deck& deck);
+};
+
+class DeckReader
+{
+  private:
+    std::ifstream file;
+
+  public:
+    DeckReader(const std::string& filename);
+    bool isOpen() const; //false if the file doesn't exist or isn't a deck recording
+    bool read(Deck& deck); //sets the order of the next recorded deal to the deck. Returns false if there are no more deals in the file.
+};
@@ -0,0 +1,192 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "duplicate.h"
+
+#include "ai.h"
+#include "event.h"
+#include "game.h"
+#include "host.h"
+#include "observer.h"
+#include "player.h"
+#include "random.h"
+#include "statistics.h"
+
+#include <cmath>
+#include <sstream>
+
+DuplicateEntrant::DuplicateEntrant(const std::string& name, AI* (*createAI)())
+: name(name)
+, createAI(createAI)
+{
+}
+
+DuplicateResult::DuplicateResult()
+: games(0)
+, deals(0)
+, score(0)
+, sequences(0)
+, sequenceScoreSum(0.0)
+, sequenceScoreSquares(0.0)
+{
+}
+
+double DuplicateResult::getScorePerDeal() const
+{
+  if(deals == 0) return 0.0;
+  return (double)score / deals;
+}
+
+double DuplicateResult::getStandardError() const
+{
+  if(sequences < 2) return 0.0;
+  double mean = sequenceScoreSum / sequences;
+  double variance = (sequenceScoreSquares - sequences * mean * mean) / (sequences - 1);
+  if(variance < 0.0) variance = 0.0;
+  return std::sqrt(variance / sequences);
+}
+
+EntrantGameResult::EntrantGameResult()
+: deals(0)
+{
+}
+
+//collects the results of one game for seatEntrants
+class ObserverEntrants : public Observer
+{
+  private:
+    EntrantGameResult& result;
+    StatKeeper* stats;
+
+  public:
+    ObserverEntrants(EntrantGameResult& result, StatKeeper* stats)
+    : result(result)
+    , stats(stats)
+    {
+    }
+
+    virtual void onEvent(const Event& event)
+    {
+      if(stats) stats->onEvent(event);
+
+      if(event.type == E_NEW_DEAL) result.deals++;
+      else if(event.type == E_TOURNAMENT_RANK)
+      {
+        result.scores[event.getPlayer()] = event.chips;
+        result.positions[event.getPlayer()] = event.position;
+      }
+      else if(event.type == E_REVEAL_AI) result.ais[event.getPlayer()] = event.getAI();
+    }
+
+    virtual EventMask getEventMask() const
+    {
+      if(stats) return EVENTMASK_ALL;
+      return eventMask(E_NEW_DEAL) | eventMask(E_TOURNAMENT_RANK) | eventMask(E_REVEAL_AI);
+    }
+};
+
+void seatEntrants(Game& game, const std::vector<DuplicateEntrant>& entrants, size_t rotation
+                , EntrantGameResult& result, StatKeeper* stats)
+{
+  game.addObserver(new ObserverEntrants(result, stats));
+
+  size_t n = entrants.size();
+  for(size_t i = 0; i < n; i++)
+  {
+    const DuplicateEntrant& entrant = entrants[(i + rotation) % n];
+    game.addPlayer(Player(entrant.createAI(), entrant.name));
+  }
+}
+
+void runDuplicate(std::vector<DuplicateResult>& results, const std::vector<DuplicateEntrant>& entrants
+                , const Rules& rules, int numSequences, uint64_t seed, Host* host)
+{
+  size_t n = entrants.size();
+
+  results.clear();
+  results.resize(n);
+  for(size_t i = 0; i < n; i++) results[i].name = entrants[i].name;
+
+  Rules duplicateRules = rules;
+  duplicateRules.allowRebuy = true;
+  if(duplicateRules.fixedNumberOfDeals <= 0) duplicateRules.fixedNumberOfDeals = 100;
+
+  RandomStream seeds(seed, 0);
+
+  for(int s = 0; s < numSequences; s++)
+  {
+    uint64_t sequenceSeed = ((uint64_t)seeds.getUint() << 32) | seeds.getUint();
+
+    std::vector<int> sequenceScores(n, 0);
+    std::vector<int> sequenceDeals(n, 0);
+
+    for(size_t r = 0; r < n; r++) //rotations
+    {
+      EntrantGameResult gameResult;
+
+      Game game(host);
+      game.setRules(duplicateRules);
+      game.setSeed(sequenceSeed);
+      seatEntrants(game, entrants, r, gameResult, 0);
+
+      game.doGame();
+
+      for(size_t i = 0; i < n; i++)
+      {
+        DuplicateResult& result = results[i];
+        int score = gameResult.scores[result.name];
+        result.games++;
+        result.deals += gameResult.deals;
+        result.score += score;
+        result.ai = gameResult.ais[result.name];
+        sequenceScores[i] += score;
+        sequenceDeals[i] += gameResult.deals;
+      }
+
+      if(host->wantToQuit()) break;
+    }
+
+    for(size_t i = 0; i < n; i++)
+    {
+      if(sequenceDeals[i] == 0) continue;
+      double perDeal = (double)sequenceScores[i] / sequenceDeals[i];
+      results[i].sequences++;
+      results[i].sequenceScoreSum += perDeal;
+      results[i].sequenceScoreSquares += perDeal * perDeal;
+    }
+
+    if(host->wantToQuit()) break;
+  }
+}
+
+std::string duplicateResultsToString(const std::vector<DuplicateResult>& results)
+{
+  std::stringstream ss;
+  for(size_t i = 0; i < results.size(); i++)
+  {
+    const DuplicateResult& r = results[i];
+    ss << r.name << " (AI: " << r.ai << "): games: " << r.games << ", deals: " << r.deals
+       << ", score: " << r.score << ", per deal: " << r.getScorePerDeal() << " +/- " << r.getStandardError() << std::endl;
+  }
+  return ss.str();
+}
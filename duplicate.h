@@ -0,0 +1,109 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "rules.h"
+
+class AI;
+class Game;
+class Host;
+class StatKeeper;
+
+/*
+Duplicate poker: comparing AI's with much less luck of the cards.
+
+The same sequence of decks is played several times, with the players rotated one seat
+further each time, so that every player gets the cards of every seat once. Good or bad
+cards then even out within one deck sequence, instead of only after a huge amount of deals.
+
+The games are seeded (see Game::setSeed), with rebuys, so that nobody leaves the table and
+each seat gets exactly the same cards in every rotation. Every game starts with newly created
+AI's, so nothing an AI remembered from a previous rotation can be used.
+*/
+
+struct DuplicateEntrant
+{
+  std::string name; //name of the player, must be unique
+  AI* (*createAI)(); //creates a new AI for this player. Called for every game.
+
+  DuplicateEntrant(const std::string& name, AI* (*createAI)());
+};
+
+struct DuplicateResult
+{
+  DuplicateResult();
+
+  std::string name;
+  std::string ai;
+
+  int games; //games played (one per rotation of each deck sequence)
+  int deals; //deals played in all games together
+  int score; //total of stack minus buy-in at the end of each game
+
+  //per deck sequence (all rotations together) score per deal, summed, and its squares summed. For the standard error.
+  int sequences;
+  double sequenceScoreSum;
+  double sequenceScoreSquares;
+
+  double getScorePerDeal() const;
+  double getStandardError() const; //standard error of getScorePerDeal, measured between the deck sequences. Needs at least 2 sequences.
+};
+
+//what comes out of one game of the entrants, per player name
+struct EntrantGameResult
+{
+  EntrantGameResult();
+
+  std::map<std::string, int> scores; //the tournament score (E_TOURNAMENT_RANK)
+  std::map<std::string, int> positions; //the finishing position
+  std::map<std::string, std::string> ais;
+  int deals;
+};
+
+/*
+Adds the entrants to the game with the seats rotated: seat i gets entrant (i + rotation) mod n.
+Also adds an observer that collects the results of the game in result (the Game deletes its
+observers, so the results are stored elsewhere), and gives all events to stats if it isn't null.
+Used by both runDuplicate and runMultiTable.
+*/
+void seatEntrants(Game& game, const std::vector<DuplicateEntrant>& entrants, size_t rotation
+                , EntrantGameResult& result, StatKeeper* stats);
+
+/*
+Runs numSequences deck sequences of rules.fixedNumberOfDeals deals each (100 if it's 0), each one
+played once per rotation of the players. Rebuys are always allowed. The deck sequences are
+generated from the seed, so the same seed gives the same results.
+results gets one entry per entrant, in the same order.
+The host can stop it early.
+*/
+void runDuplicate(std::vector<DuplicateResult>& results, const std::vector<DuplicateEntrant>& entrants
+                , const Rules& rules, int numSequences, uint64_t seed, Host* host);
+
+std::string duplicateResultsToString(const std::vector<DuplicateResult>& results);
@@ -0,0 +1,197 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+Exhaustive enumeration of card subsets, for the exhaustive win chance calculations
+in pokermath.cpp (and anything else that needs to visit all possible runouts).
+
+The cards are integers in the eval7_index format (0-51), and a set of cards is
+given as a CardMask, where bit i is set if the card with eval7 index i is in the set.
+
+The enumeration is compile-time specialized on the amount of cards K: it unrolls
+into K nested loops, just like the hand-written loops would, but the code that
+uses it is written only once, as a functor.
+*/
+
+#include <stdint.h>
+
+typedef uint64_t CardMask;
+
+static const CardMask CARDMASK_ALL = 0x000FFFFFFFFFFFFFULL; //all 52 cards
+
+inline CardMask cardToMask(int card /*eval7_index*/)
+{
+  return (CardMask)1 << card;
+}
+
+inline CardMask cardsToMask(const int* cards, int num)
+{
+  CardMask result = 0;
+  for(int i = 0; i < num; i++) result |= cardToMask(cards[i]);
+  return result;
+}
+
+//fills cards with the eval7 indices of all cards in the mask, from low to high. Returns how many there are. cards must have room for 52 values.
+inline int maskToCards(int* cards, CardMask mask)
+{
+  int num = 0;
+  for(int i = 0; i < 52; i++)
+  {
+    if((mask >> i) & 1) cards[num++] = i;
+  }
+  return num;
+}
+
+//Binomial coefficient as exact integer (unlike "combination" from pokermath.h, which uses doubles)
+inline uint64_t binomial(int n, int k)
+{
+  if(k < 0 || k > n) return 0;
+  if(k > n - k) k = n - k;
+  uint64_t result = 1;
+  for(int i = 1; i <= k; i++) result = result * (n - k + i) / i; //exact: every partial result is a binomial coefficient itself
+  return result;
+}
+
+/*
+KSubsets<K> visits all K-element subsets of values[0..end[, in colex order: the
+subsets are ordered by their highest element first, then their second highest, etc...
+
+The chosen values are written to out[0] .. out[K - 1], with out[K - 1] the one that
+changes the least often. After each subset is written, f(out) is called. Because
+the values are written in place, out can point straight into the array of 7 cards
+that is going to be evaluated, so no copying is needed.
+
+runRange is the same, but only visits the subsets whose highest element has an index
+in [begin, end[. That allows splitting one enumeration into independent parts.
+*/
+template<int K>
+struct KSubsets
+{
+  template<typename F>
+  static void run(const int* values, int end, int* out, F& f)
+  {
+    runRange(values, K - 1, end, out, f);
+  }
+
+  template<typename F>
+  static void runRange(const int* values, int begin, int end, int* out, F& f)
+  {
+    if(begin < K - 1) begin = K - 1;
+    for(int i = begin; i < end; i++)
+    {
+      out[K - 1] = values[i];
+      KSubsets<K - 1>::run(values, i, out, f);
+    }
+  }
+};
+
+template<>
+struct KSubsets<0>
+{
+  template<typename F>
+  static void run(const int* values, int end, int* out, F& f)
+  {
+    (void)values;
+    (void)end;
+    f(out);
+  }
+
+  template<typename F>
+  static void runRange(const int* values, int begin, int end, int* out, F& f)
+  {
+    if(begin < end) run(values, end, out, f); //there is only one empty set, so only one part gets a non-empty range
+  }
+};
+
+/*
+Splitting an enumeration of all k-subsets of n values into numParts independent parts
+of roughly the same amount of subsets, e.g. to let each part run on its own thread.
+Gives the range of the highest element for the given part, to be used with runRange.
+*/
+inline void getKSubsetsPartRange(int& begin, int& end, int k, int n, int part, int numParts)
+{
+  if(k == 0)
+  {
+    begin = 0;
+    end = (part == 0) ? 1 : 0;
+    return;
+  }
+  if(numParts <= 1)
+  {
+    begin = 0;
+    end = n;
+    return;
+  }
+
+  uint64_t total = binomial(n, k);
+  uint64_t from = total * part / numParts;
+  uint64_t to = total * (part + 1) / numParts;
+
+  //the amount of subsets with highest element i is binomial(i, k - 1), so the cumulative amount before i is binomial(i, k)
+  begin = end = n;
+  for(int i = k - 1; i < n; i++)
+  {
+    uint64_t before = binomial(i, k);
+    if(begin == n && before >= from) begin = i;
+    if(before >= to) { end = i; break; }
+  }
+  if(part == numParts - 1) end = n;
+  if(begin > end) begin = end;
+}
+
+/*
+Runtime dispatch to the compile time specialized KSubsets for k = 0 to 7.
+Calls f(out) for each k-subset of values[0..n[, see KSubsets for the details.
+
+part and numParts are optional: with numParts > 1, only the given part (0 to numParts - 1)
+of all the subsets is visited. All the parts together visit every subset exactly once.
+*/
+template<typename F>
+void enumerateKSubsets(int k, const int* values, int n, int* out, F& f, int part = 0, int numParts = 1)
+{
+  int begin, end;
+  getKSubsetsPartRange(begin, end, k, n, part, numParts);
+
+  switch(k)
+  {
+    case 0: KSubsets<0>::runRange(values, begin, end, out, f); break;
+    case 1: KSubsets<1>::runRange(values, begin, end, out, f); break;
+    case 2: KSubsets<2>::runRange(values, begin, end, out, f); break;
+    case 3: KSubsets<3>::runRange(values, begin, end, out, f); break;
+    case 4: KSubsets<4>::runRange(values, begin, end, out, f); break;
+    case 5: KSubsets<5>::runRange(values, begin, end, out, f); break;
+    case 6: KSubsets<6>::runRange(values, begin, end, out, f); break;
+    case 7: KSubsets<7>::runRange(values, begin, end, out, f); break;
+    default: break;
+  }
+}
+
+//same as enumerateKSubsets, but for the cards of a CardMask: each k-card subset of the cards in the mask is written to out.
+template<typename F>
+void enumerateKSubsets(int k, CardMask mask, int* out, F& f, int part = 0, int numParts = 1)
+{
+  int values[52];
+  int n = maskToCards(values, mask);
+  enumerateKSubsets(k, values, n, out, f, part, numParts);
+}
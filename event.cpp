@@ -26,170 +26,490 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #include "player.h"
 #include "observer.h"
 
+#include <algorithm>
+#include <cstring>
 #include <sstream>
+#include <type_traits>
 
+static_assert(std::is_trivially_copyable<Event>::value, "Event must stay a plain struct, see event.h");
 
+
+//all ids are -1 and all values 0 unless set, so that events are exactly the same every run (e.g. when written to a file)
 Event::Event(EventType type)
 : type(type)
+, playerId(-1)
+, chips(0)
+, smallBlind(0)
+, bigBlind(0)
+, ante(0)
+, position(0)
+, messageId(-1)
+, strings(0)
 {
 }
 
-Event::Event(EventType type, const std::string& player)
-: type(type)
-, player(player)
+Event::Event(EventType type, int playerId)
+: Event(type)
 {
+  this->playerId = playerId;
 }
 
-Event::Event(EventType type, const std::string& player, int chips)
-: type(type)
-, player(player)
-, chips(chips)
+Event::Event(EventType type, int playerId, int chips)
+: Event(type)
 {
+  this->playerId = playerId;
+  this->chips = chips;
 }
 
-Event::Event(EventType type, int position, const std::string& player)
-: type(type)
-, player(player)
-, position(position)
+Event::Event(EventType type, const Card& card1)
+: Event(type)
 {
+  this->card1 = card1;
 }
 
-Event::Event(EventType type, int position, int chips, const std::string& player)
-: type(type)
-, player(player)
-, chips(chips)
-, position(position)
+Event::Event(EventType type, const Card& card1, const Card& card2)
+: Event(type)
 {
+  this->card1 = card1;
+  this->card2 = card2;
 }
 
-Event::Event(EventType type, const std::string& player, const std::string& ai)
-: type(type)
-, player(player)
-, ai(ai)
+Event::Event(EventType type, const Card& card1, const Card& card2, const Card& card3)
+: Event(type)
 {
+  this->card1 = card1;
+  this->card2 = card2;
+  this->card3 = card3;
 }
 
-Event::Event(EventType type, const Card& card1)
-: type(type)
-, card1(card1)
+Event::Event(EventType type, const Card& card1, const Card& card2, const Card& card3, const Card& card4)
+: Event(type)
 {
+  this->card1 = card1;
+  this->card2 = card2;
+  this->card3 = card3;
+  this->card4 = card4;
 }
 
-Event::Event(EventType type, const Card& card1, const Card& card2)
-: type(type)
-, card1(card1)
-, card2(card2)
+Event::Event(EventType type, const Card& card1, const Card& card2, const Card& card3, const Card& card4, const Card& card5)
+: Event(type)
 {
+  this->card1 = card1;
+  this->card2 = card2;
+  this->card3 = card3;
+  this->card4 = card4;
+  this->card5 = card5;
 }
 
-Event::Event(EventType type, const Card& card1, const Card& card2, const Card& card3)
-: type(type)
-, card1(card1)
-, card2(card2)
-, card3(card3)
+Event::Event(EventType type, int playerId, const Card& card1, const Card& card2, const Card& card3, const Card& card4, const Card& card5)
+: Event(type, card1, card2, card3, card4, card5)
 {
+  this->playerId = playerId;
 }
 
-Event::Event(EventType type, const Card& card1, const Card& card2, const Card& card3, const Card& card4)
-: type(type)
-, card1(card1)
-, card2(card2)
-, card3(card3)
-, card4(card4)
+Event::Event(EventType type, int playerId, const Card& card1, const Card& card2)
+: Event(type, card1, card2)
 {
+  this->playerId = playerId;
 }
 
-Event::Event(EventType type, const Card& card1, const Card& card2, const Card& card3, const Card& card4, const Card& card5)
-: type(type)
-, card1(card1)
-, card2(card2)
-, card3(card3)
-, card4(card4)
-, card5(card5)
+Event::Event(EventType type, int smallBlind, int bigBlind, int ante)
+: Event(type)
 {
+  this->smallBlind = smallBlind;
+  this->bigBlind = bigBlind;
+  this->ante = ante;
 }
 
-Event::Event(EventType type, const std::string& player, const Card& card1, const Card& card2, const Card& card3, const Card& card4, const Card& card5)
-: type(type)
-, player(player)
-, card1(card1)
-, card2(card2)
-, card3(card3)
-, card4(card4)
-, card5(card5)
+static const std::string emptyString;
+
+bool Event::hasPlayer() const
 {
+  return playerId >= 0 && strings;
 }
 
-Event::Event(EventType type, const std::string& player, const Card& card1, const Card& card2)
-: type(type)
-, player(player)
-, card1(card1)
-, card2(card2)
+const std::string& Event::getPlayer() const
 {
+  if(!hasPlayer() || playerId >= (int)strings->players.size()) return emptyString;
+  return strings->players[playerId];
 }
-Event::Event(const std::string& message, EventType type)
-: type(type)
-, message(message)
+
+const std::string& Event::getAI() const
 {
+  if(!hasPlayer() || playerId >= (int)strings->ais.size()) return emptyString;
+  return strings->ais[playerId];
 }
 
-Event::Event(EventType type, int smallBlind, int bigBlind, int ante)
-: type(type)
-, smallBlind(smallBlind)
-, bigBlind(bigBlind)
-, ante(ante)
+const std::string& Event::getMessage() const
 {
+  if(messageId < 0 || !strings || messageId >= (int)strings->messages.size()) return emptyString;
+  return strings->messages[messageId];
 }
 
-std::string eventToString(const Event& event)
+int EventStrings::addPlayer(const std::string& name, const std::string& ai)
 {
-  std::stringstream ss;
-  std::string playerName = event.player;
+  players.push_back(name);
+  ais.push_back(ai);
+  return (int)players.size() - 1;
+}
+
+int EventStrings::addMessage(const std::string& message)
+{
+  messages.push_back(message);
+  return (int)messages.size() - 1;
+}
+
+//appends the number in decimal, without going through a stringstream
+static void appendInt(std::string& out, int value)
+{
+  char buffer[16];
+  int pos = 16;
+  unsigned u = value < 0 ? 0u - (unsigned)value : (unsigned)value;
+  do
+  {
+    buffer[--pos] = '0' + (u % 10);
+    u /= 10;
+  } while(u > 0);
+  if(value < 0) buffer[--pos] = '-';
+  out.append(buffer + pos, 16 - pos);
+}
+
+static void appendPlayerChips(std::string& out, const char* text, const Event& event)
+{
+  out += text;
+  out += event.getPlayer();
+  out += ", chips: ";
+  appendInt(out, event.chips);
+}
+
+static void appendPlayerCards(std::string& out, const char* text, const Event& event)
+{
+  out += text;
+  out += event.getPlayer();
+  out += ", ";
+  out += event.card1.getShortName();
+  out += ' ';
+  out += event.card2.getShortName();
+}
 
+void appendEventString(std::string& out, const Event& event)
+{
   switch(event.type)
   {
-    case E_JOIN: ss << "Joins: " << playerName << ", chips: " << event.chips; break;
-    case E_QUIT: ss << "Quits: " << playerName << ", chips: " << event.chips; break;
-    case E_REBUY: ss << "Player " << playerName << " rebuys with " << event.chips << " chips"; break;
-    case E_SMALL_BLIND: ss << "Small Blind: " << playerName << ", chips: " << event.chips; break;
-    case E_BIG_BLIND: ss << "Big Blind: " << playerName << ", chips: " << event.chips; break;
-    case E_ANTE: ss << "Ante: " << playerName << ", chips: " << event.chips; break;
-    case E_FOLD: ss << "Folds: " << playerName ; break;
-    case E_CHECK: ss << "Checks: " << playerName; break;
-    case E_CALL: ss << "Calls: " << playerName; break;
-    case E_RAISE: ss << "Raises: " << playerName << ", chips: " << event.chips; break;
-    case E_NEW_DEAL: ss << "New deal." << " SB: " << event.smallBlind << " BB: " << event.bigBlind << " Ante: " << event.ante; break;
-    case E_RECEIVE_CARDS: ss << "Received cards: " << event.card1.getShortName() << " " << event.card2.getShortName(); break;
-    case E_FLOP: ss << "Flop: " << event.card1.getShortName() << " " << event.card2.getShortName() << " " << event.card3.getShortName(); break;
-    case E_TURN: ss << "Turn: " << event.card4.getShortName(); break;
-    case E_RIVER: ss << "River: " << event.card5.getShortName(); break;
-    case E_SHOWDOWN: ss << "Showdown Reached"; break;
-    case E_POT_DIVISION: ss << "Pot size: " << event.chips; break;
-    case E_WIN: ss << "Wins: " << playerName << ", chips: " << event.chips; break;
-    case E_PLAYER_SHOWDOWN: ss  << "Shows: " << playerName << ", "  << event.card1.getShortName() << " " << event.card2.getShortName(); break;
-    case E_BOAST: ss  << "Boasts: " << playerName << ", "  << event.card1.getShortName() << " " << event.card2.getShortName(); break;
+    case E_JOIN: appendPlayerChips(out, "Joins: ", event); break;
+    case E_QUIT: appendPlayerChips(out, "Quits: ", event); break;
+    case E_REBUY: out += "Player "; out += event.getPlayer(); out += " rebuys with "; appendInt(out, event.chips); out += " chips"; break;
+    case E_SMALL_BLIND: appendPlayerChips(out, "Small Blind: ", event); break;
+    case E_BIG_BLIND: appendPlayerChips(out, "Big Blind: ", event); break;
+    case E_ANTE: appendPlayerChips(out, "Ante: ", event); break;
+    case E_FOLD: out += "Folds: "; out += event.getPlayer(); break;
+    case E_CHECK: out += "Checks: "; out += event.getPlayer(); break;
+    case E_CALL: out += "Calls: "; out += event.getPlayer(); break;
+    case E_RAISE: appendPlayerChips(out, "Raises: ", event); break;
+    case E_NEW_DEAL:
+      out += "New deal. SB: "; appendInt(out, event.smallBlind);
+      out += " BB: "; appendInt(out, event.bigBlind);
+      out += " Ante: "; appendInt(out, event.ante);
+      break;
+    case E_RECEIVE_CARDS: out += "Received cards: "; out += event.card1.getShortName(); out += ' '; out += event.card2.getShortName(); break;
+    case E_FLOP: out += "Flop: "; out += event.card1.getShortName(); out += ' '; out += event.card2.getShortName(); out += ' '; out += event.card3.getShortName(); break;
+    case E_TURN: out += "Turn: "; out += event.card4.getShortName(); break;
+    case E_RIVER: out += "River: "; out += event.card5.getShortName(); break;
+    case E_SHOWDOWN: out += "Showdown Reached"; break;
+    case E_POT_DIVISION: out += "Pot size: "; appendInt(out, event.chips); break;
+    case E_WIN: appendPlayerChips(out, "Wins: ", event); break;
+    case E_PLAYER_SHOWDOWN: appendPlayerCards(out, "Shows: ", event); break;
+    case E_BOAST: appendPlayerCards(out, "Boasts: ", event); break;
     case E_COMBINATION:
     {
       Combination combo;
       getCombo(combo, event.card1, event.card2, event.card3, event.card4, event.card5);
-      ss  << "Combination: " << playerName << ", " << combo.getNameWithAllCards();
+      out += "Combination: "; out += event.getPlayer(); out += ", "; out += combo.getNameWithAllCards();
       break;
     }
-    case E_DEALER: ss << "Dealer: " << playerName; break;
-    case E_TOURNAMENT_RANK: ss << "Ranking: " << playerName << ", Place: " << event.position << ", Score: " << event.chips; break;
-    case E_REVEAL_AI: ss << "Reveal AI: " << playerName << ", AI: " << event.ai; break;
-    case E_LOG_MESSAGE: ss << event.message; break;
-    case E_DEBUG_MESSAGE: ss << "DEBUG MESSAGE: " << event.message; break;
-    default: ss << "??????";
+    case E_DEALER: out += "Dealer: "; out += event.getPlayer(); break;
+    case E_TOURNAMENT_RANK:
+      out += "Ranking: "; out += event.getPlayer();
+      out += ", Place: "; appendInt(out, event.position);
+      out += ", Score: "; appendInt(out, event.chips);
+      break;
+    case E_REVEAL_AI: out += "Reveal AI: "; out += event.getPlayer(); out += ", AI: "; out += event.getAI(); break;
+    case E_LOG_MESSAGE: out += event.getMessage(); break;
+    case E_DEBUG_MESSAGE: out += "DEBUG MESSAGE: "; out += event.getMessage(); break;
+    default: out += "??????";
   }
+}
 
-  return ss.str();
+std::string eventToString(const Event& event)
+{
+  std::string result;
+  appendEventString(result, event);
+  return result;
+}
+
+static bool startsWith(const char* begin, const char* end, const char* prefix, const char*& rest)
+{
+  const char* p = begin;
+  while(*prefix)
+  {
+    if(p == end || *p != *prefix) return false;
+    p++;
+    prefix++;
+  }
+  rest = p;
+  return true;
+}
+
+//returns the position of the last occurrence of pattern in [begin, end[, or null if it's not there
+static const char* findLast(const char* begin, const char* end, const char* pattern)
+{
+  size_t n = std::strlen(pattern);
+  if((size_t)(end - begin) < n) return 0;
+  for(size_t i = (end - begin) - n + 1; i > 0; i--)
+  {
+    if(std::memcmp(begin + i - 1, pattern, n) == 0) return begin + i - 1;
+  }
+  return 0;
+}
+
+static bool parseInt(int& value, const char* begin, const char* end)
+{
+  bool negative = begin != end && *begin == '-';
+  if(negative) begin++;
+  if(begin == end) return false;
+  int result = 0;
+  for(const char* p = begin; p != end; p++)
+  {
+    if(*p < '0' || *p > '9') return false;
+    result = result * 10 + (*p - '0');
+  }
+  value = negative ? -result : result;
+  return true;
+}
+
+//parses a card name such as "Ah" at p, if there are 2 characters left. An unknown card ("?") gives an invalid card.
+static bool parseCard(Card& card, const char*& p, const char* end)
+{
+  if(p != end && *p == '?')
+  {
+    card = Card();
+    p++;
+    return true;
+  }
+  if(end - p < 2) return false;
+  static const char* values = "23456789TJQKA";
+  static const char* suits = "cdhs";
+  const char* v = std::strchr(values, p[0]);
+  const char* s = std::strchr(suits, p[1]);
+  if(!v || !s || !p[0] || !p[1]) return false;
+  card = Card((int)(v - values) + 2, (Suit)(s - suits));
+  p += 2;
+  return true;
+}
+
+//parses num cards separated by single spaces, that must end exactly at end
+static bool parseCards(Card* cards, int num, const char* p, const char* end)
+{
+  for(int i = 0; i < num; i++)
+  {
+    if(i > 0 && (p == end || *p++ != ' ')) return false;
+    if(!parseCard(cards[i], p, end)) return false;
+  }
+  return p == end;
+}
+
+EventParser::EventParser()
+{
+  strings.messages.resize(1); //all messages use id 0, since there's only one event at a time
+}
+
+const EventStrings& EventParser::getStrings() const
+{
+  return strings;
+}
+
+int EventParser::getPlayerId(const char* begin, const char* end)
+{
+  //usually there are only a few players, then comparing the names is faster than hashing
+  size_t size = end - begin;
+  if(strings.players.size() <= 16)
+  {
+    for(size_t i = 0; i < strings.players.size(); i++)
+    {
+      const std::string& name = strings.players[i];
+      if(name.size() == size && std::memcmp(name.data(), begin, size) == 0) return (int)i;
+    }
+  }
+
+  key.assign(begin, end);
+  std::unordered_map<std::string, int>::const_iterator it = playerIds.find(key);
+  if(it != playerIds.end()) return it->second;
+  int id = strings.addPlayer(key, "");
+  playerIds[key] = id;
+  return id;
+}
+
+bool EventParser::parse(Event& event, const std::string& line)
+{
+  return parse(event, line.data(), line.data() + line.size());
+}
+
+bool EventParser::parse(Event& event, const char* begin, const char* end)
+{
+  if(end != begin && end[-1] == '\r') end--;
+  if(begin == end) return false;
+
+  const char* rest;
+  if(startsWith(begin, end, "=====", rest) || startsWith(begin, end, "Date: ", rest)) return false; //the title of a log
+
+  event = Event(E_NUM_EVENTS);
+  event.strings = &strings;
+
+  if(!parseEvent(event, begin, end))
+  {
+    event = Event(E_LOG_MESSAGE);
+    event.strings = &strings;
+    event.messageId = 0;
+    strings.messages[0].assign(begin, end);
+  }
+  return true;
+}
+
+//the events written as "<prefix><player>, chips: <chips>"
+static const struct { const char* prefix; EventType type; } PLAYER_CHIPS_EVENTS[] =
+{
+  { "Joins: ", E_JOIN }, { "Quits: ", E_QUIT }, { "Small Blind: ", E_SMALL_BLIND }, { "Big Blind: ", E_BIG_BLIND },
+  { "Ante: ", E_ANTE }, { "Raises: ", E_RAISE }, { "Wins: ", E_WIN }
+};
+
+//the events written as "<prefix><player>"
+static const struct { const char* prefix; EventType type; } PLAYER_EVENTS[] =
+{
+  { "Folds: ", E_FOLD }, { "Checks: ", E_CHECK }, { "Calls: ", E_CALL }, { "Dealer: ", E_DEALER }
+};
+
+//returns false if it isn't a well formed event line
+bool EventParser::parseEvent(Event& event, const char* begin, const char* end)
+{
+  const char* p;
+  const char* q;
+
+  for(size_t i = 0; i < sizeof(PLAYER_CHIPS_EVENTS) / sizeof(*PLAYER_CHIPS_EVENTS); i++)
+  {
+    if(!startsWith(begin, end, PLAYER_CHIPS_EVENTS[i].prefix, p)) continue;
+    q = findLast(p, end, ", chips: ");
+    if(!q || !parseInt(event.chips, q + 9, end)) return false;
+    event.type = PLAYER_CHIPS_EVENTS[i].type;
+    event.playerId = getPlayerId(p, q);
+    return true;
+  }
+
+  for(size_t i = 0; i < sizeof(PLAYER_EVENTS) / sizeof(*PLAYER_EVENTS); i++)
+  {
+    if(!startsWith(begin, end, PLAYER_EVENTS[i].prefix, p)) continue;
+    event.type = PLAYER_EVENTS[i].type;
+    event.playerId = getPlayerId(p, end);
+    return true;
+  }
+
+  if(startsWith(begin, end, "Flop: ", p))
+  {
+    if(!parseCards(board, 3, p, end)) return false;
+    board[3] = board[4] = Card();
+    event = Event(E_FLOP, board[0], board[1], board[2]);
+  }
+  else if(startsWith(begin, end, "Turn: ", p))
+  {
+    if(!parseCards(&board[3], 1, p, end)) return false;
+    event = Event(E_TURN, board[0], board[1], board[2], board[3]);
+  }
+  else if(startsWith(begin, end, "River: ", p))
+  {
+    if(!parseCards(&board[4], 1, p, end)) return false;
+    event = Event(E_RIVER, board[0], board[1], board[2], board[3], board[4]);
+  }
+  else if(startsWith(begin, end, "New deal. SB: ", p))
+  {
+    const char* bb = findLast(p, end, " BB: ");
+    const char* ante = findLast(p, end, " Ante: ");
+    if(!bb || !ante || ante < bb) return false;
+    if(!parseInt(event.smallBlind, p, bb) || !parseInt(event.bigBlind, bb + 5, ante) || !parseInt(event.ante, ante + 7, end)) return false;
+    event.type = E_NEW_DEAL;
+    for(int i = 0; i < 5; i++) board[i] = Card();
+  }
+  else if(startsWith(begin, end, "Pot size: ", p))
+  {
+    if(!parseInt(event.chips, p, end)) return false;
+    event.type = E_POT_DIVISION;
+  }
+  else if(startsWith(begin, end, "Showdown Reached", p))
+  {
+    if(p != end) return false;
+    event.type = E_SHOWDOWN;
+  }
+  else if(startsWith(begin, end, "Shows: ", p) || startsWith(begin, end, "Boasts: ", p))
+  {
+    q = findLast(p, end, ", ");
+    Card cards[2];
+    if(!q || !parseCards(cards, 2, q + 2, end)) return false;
+    event = Event(begin[0] == 'S' ? E_PLAYER_SHOWDOWN : E_BOAST, getPlayerId(p, q), cards[0], cards[1]);
+  }
+  else if(startsWith(begin, end, "Received cards: ", p))
+  {
+    Card cards[2];
+    if(!parseCards(cards, 2, p, end)) return false;
+    event = Event(E_RECEIVE_CARDS, cards[0], cards[1]);
+  }
+  else if(startsWith(begin, end, "Combination: ", p))
+  {
+    //"Combination: <player>, <name of the combination> ( <the 5 cards> )"
+    const char* cards = findLast(p, end, " ( ");
+    if(!cards || end - cards < 5 || std::memcmp(end - 2, " )", 2) != 0) return false;
+    q = findLast(p, cards, ", ");
+    Card c[5];
+    if(!q || !parseCards(c, 5, cards + 3, end - 2)) return false;
+    event = Event(E_COMBINATION, getPlayerId(p, q), c[0], c[1], c[2], c[3], c[4]);
+  }
+  else if(startsWith(begin, end, "Ranking: ", p))
+  {
+    q = findLast(p, end, ", Place: ");
+    const char* score = findLast(p, end, ", Score: ");
+    if(!q || !score || score < q) return false;
+    if(!parseInt(event.position, q + 9, score) || !parseInt(event.chips, score + 9, end)) return false;
+    event.type = E_TOURNAMENT_RANK;
+    event.playerId = getPlayerId(p, q);
+  }
+  else if(startsWith(begin, end, "Reveal AI: ", p))
+  {
+    q = findLast(p, end, ", AI: ");
+    if(!q) return false;
+    event.type = E_REVEAL_AI;
+    event.playerId = getPlayerId(p, q);
+    strings.ais[event.playerId].assign(q + 6, end);
+  }
+  else if(startsWith(begin, end, "Player ", p) && (q = findLast(p, end, " rebuys with ")) != 0)
+  {
+    const char* chips = q + 13;
+    if(end - chips < 6 || std::memcmp(end - 6, " chips", 6) != 0 || !parseInt(event.chips, chips, end - 6)) return false;
+    event.type = E_REBUY;
+    event.playerId = getPlayerId(p, q);
+  }
+  else if(startsWith(begin, end, "DEBUG MESSAGE: ", p))
+  {
+    event.type = E_DEBUG_MESSAGE;
+    event.messageId = 0;
+    strings.messages[0].assign(p, end);
+  }
+  else return false;
+
+  event.strings = &strings;
+  return true;
 }
 
 std::string eventToStringVerbose(const Event& event)
 {
   std::stringstream ss;
-  std::string playerName = event.player;
+  const std::string& playerName = event.getPlayer();
 
   switch(event.type)
   {
@@ -222,38 +542,188 @@ std::string eventToStringVerbose(const Event& event)
     }
     case E_DEALER: ss << "Player " << playerName << " is dealer"; break;
     case E_TOURNAMENT_RANK: ss << "Player " << playerName << " finishes at place " << event.position << ". Score: " << event.chips; break;
-    case E_REVEAL_AI: ss << "The AI of player " << playerName << " was: " << event.ai; break;
-    case E_LOG_MESSAGE: ss << event.message; break;
-    case E_DEBUG_MESSAGE: ss << "DEBUG MESSAGE: " << event.message; break;
+    case E_REVEAL_AI: ss << "The AI of player " << playerName << " was: " << event.getAI(); break;
+    case E_LOG_MESSAGE: ss << event.getMessage(); break;
+    case E_DEBUG_MESSAGE: ss << "DEBUG MESSAGE: " << event.getMessage(); break;
     default: ss << "??????";
   }
 
   return ss.str();
 }
 
-void sendEventToPlayers(std::vector<Player>& players, const Event& event)
+static_assert(E_NUM_EVENTS <= 32, "EventMask has a bit for each event type");
+
+void EventDispatcher::setup(std::vector<Player>& players, std::vector<Observer*>& observers)
 {
- for(size_t i = 0; i < players.size(); i++)
- {
-   if(!players[i].isHuman() && (event.type == E_LOG_MESSAGE || event.type == E_DEBUG_MESSAGE)) continue; //AI's are not allowed to get this information.
-   players[i].onEvent(event);
- }
+  for(int type = 0; type < E_NUM_EVENTS; type++)
+  {
+    this->players[type].clear();
+    this->observers[type].clear();
+
+    for(size_t i = 0; i < players.size(); i++)
+    {
+      if(!players[i].isHuman() && (type == E_LOG_MESSAGE || type == E_DEBUG_MESSAGE)) continue; //AI's are not allowed to get this information.
+      if(players[i].getEventMask() & eventMask((EventType)type)) this->players[type].push_back(&players[i]);
+    }
+    for(size_t i = 0; i < observers.size(); i++)
+    {
+      if(observers[i]->getEventMask() & eventMask((EventType)type)) this->observers[type].push_back(observers[i]);
+    }
+  }
 }
-void sendEventToObservers(std::vector<Observer*>& observers, const Event& event)
+
+void EventDispatcher::send(const Event& event) const
 {
- for(size_t i = 0; i < observers.size(); i++)
- {
-    observers[i]->onEvent(event);
- }
+  if(event.type < 0 || event.type >= E_NUM_EVENTS) return;
+
+  const std::vector<Player*>& p = players[event.type];
+  for(size_t i = 0; i < p.size(); i++) p[i]->onEvent(event);
+
+  const std::vector<Observer*>& o = observers[event.type];
+  for(size_t i = 0; i < o.size(); i++) o[i]->onEvent(event);
 }
 
-void sendEventsToPlayers(size_t& counter, std::vector<Player>& players, std::vector<Observer*>& observers, const std::vector<Event>& events)
+void EventDispatcher::send(size_t& counter, const std::vector<Event>& events) const
 {
-  for(size_t i = counter; i < events.size(); i++)
-  {
-    sendEventToPlayers(players, events[i]);
-    sendEventToObservers(observers, events[i]);
-  }
+  for(size_t i = counter; i < events.size(); i++) send(events[i]);
 
   counter = events.size();
 }
+
+////////////////////////////////////////////////////////////////////////////////
+
+static const char EVENT_JOURNAL_MAGIC[8] = { 'O', 'O', 'P', 'E', 'V', 'T', 'S', '1' };
+
+EventJournalWriter::EventJournalWriter(const std::string& filename)
+: file(filename.c_str(), std::ios::out|std::ios::binary)
+, numPlayers(0)
+{
+  if(file) file.write(EVENT_JOURNAL_MAGIC, 8);
+}
+
+bool EventJournalWriter::isOpen() const
+{
+  return file.good();
+}
+
+void EventJournalWriter::writeInt(int value)
+{
+  unsigned int v = (unsigned int)value;
+  char bytes[4] = { (char)(v & 255), (char)((v >> 8) & 255), (char)((v >> 16) & 255), (char)((v >> 24) & 255) };
+  file.write(bytes, 4);
+}
+
+void EventJournalWriter::writeString(const std::string& s)
+{
+  writeInt((int)s.size());
+  file.write(s.data(), s.size());
+}
+
+void EventJournalWriter::write(const Event& event)
+{
+  if(event.strings)
+  {
+    for(; numPlayers < event.strings->players.size(); numPlayers++)
+    {
+      file.put('P');
+      writeInt((int)numPlayers);
+      writeString(event.strings->players[numPlayers]);
+      writeString(event.strings->ais[numPlayers]);
+    }
+
+    if(event.messageId >= 0)
+    {
+      file.put('M');
+      writeInt(event.messageId);
+      writeString(event.getMessage());
+    }
+  }
+
+  file.put('E');
+  writeInt((int)event.type);
+  writeInt(event.playerId);
+  writeInt(event.chips);
+  writeInt(event.smallBlind);
+  writeInt(event.bigBlind);
+  writeInt(event.ante);
+  writeInt(event.position);
+  writeInt(event.messageId);
+  const Card* cards[5] = { &event.card1, &event.card2, &event.card3, &event.card4, &event.card5 };
+  for(int i = 0; i < 5; i++) writeInt(cards[i]->isValid() ? cards[i]->getIndex() : -1);
+}
+
+EventJournalReader::EventJournalReader(const std::string& filename)
+: file(filename.c_str(), std::ios::in|std::ios::binary)
+{
+  char magic[8];
+  if(file.read(magic, 8) && std::equal(magic, magic + 8, EVENT_JOURNAL_MAGIC)) return;
+  file.setstate(std::ios::failbit);
+}
+
+bool EventJournalReader::isOpen() const
+{
+  return file.good();
+}
+
+bool EventJournalReader::readInt(int& value)
+{
+  unsigned char bytes[4];
+  if(!file.read((char*)bytes, 4)) return false;
+  value = (int)(bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((unsigned int)bytes[3] << 24));
+  return true;
+}
+
+bool EventJournalReader::readString(std::string& s)
+{
+  int size;
+  if(!readInt(size) || size < 0) return false;
+  s.resize(size);
+  return size == 0 || (bool)file.read(&s[0], size);
+}
+
+bool EventJournalReader::read(Event& event)
+{
+  for(;;)
+  {
+    int kind = file.get();
+    if(kind == 'P' || kind == 'M')
+    {
+      int id;
+      if(!readInt(id) || id < 0) return false;
+      std::vector<std::string>& list = (kind == 'P') ? strings.players : strings.messages;
+      if((int)list.size() <= id) list.resize(id + 1);
+      if(!readString(list[id])) return false;
+      if(kind == 'P')
+      {
+        if((int)strings.ais.size() <= id) strings.ais.resize(id + 1);
+        if(!readString(strings.ais[id])) return false;
+      }
+    }
+    else if(kind == 'E')
+    {
+      int values[13];
+      for(int i = 0; i < 13; i++)
+      {
+        if(!readInt(values[i])) return false;
+      }
+      if(values[0] < 0 || values[0] >= E_NUM_EVENTS) return false; //corrupt file
+
+      event = Event((EventType)values[0]);
+      event.playerId = values[1];
+      event.chips = values[2];
+      event.smallBlind = values[3];
+      event.bigBlind = values[4];
+      event.ante = values[5];
+      event.position = values[6];
+      event.messageId = values[7];
+      Card* cards[5] = { &event.card1, &event.card2, &event.card3, &event.card4, &event.card5 };
+      for(int i = 0; i < 5; i++)
+      {
+        if(values[8 + i] >= 0 && values[8 + i] < 52) cards[i]->setIndex(values[8 + i]);
+      }
+      event.strings = &strings;
+      return true;
+    }
+    else return false; //end of file or corrupt
+  }
+}
@@ -22,7 +22,10 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include <fstream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "card.h"
 
@@ -33,7 +36,7 @@ enum EventType
 {
   //an EventType has some information associated with it in the Event struct.
   //The comment at to each event says which info exactly, if any.
-  //If an event is related to a player, the player is always given as a string (not as an index). You can use those player names to uniquely identify them.
+  //If an event is related to a player, the player is given as a player id (not as an index at the table), see Event::getPlayer for the name. The ids and the names uniquely identify the players.
 
   //info used: player, chips (with how much chips this player joins)
   E_JOIN, //player joins table
@@ -116,19 +119,55 @@ enum EventType
   E_NUM_EVENTS //don't use
 };
 
+/*
+A set of event types, bit i is set for EventType i. AI's and observers use this to say which
+events they want to get (see getEventMask in ai.h and observer.h), the others aren't sent to them.
+*/
+typedef unsigned int EventMask;
+
+static const EventMask EVENTMASK_ALL = 0xFFFFFFFFu;
+
+inline EventMask eventMask(EventType type)
+{
+  return 1u << type;
+}
+
+/*
+The strings the events refer to. The events themselves only contain ids, so that creating,
+storing and sending events never allocates memory. Each Game has its own EventStrings, which
+stays alive as long as the Game.
+The player names and AI names stay the same for the whole game, but the Game recycles the
+messages once all players and observers got their events, so getMessage only works during onEvent.
+*/
+struct EventStrings
+{
+  std::vector<std::string> players; //the player names, indexed by player id
+  std::vector<std::string> ais; //the AI names of the players, indexed by player id
+  std::vector<std::string> messages; //the texts of the E_LOG_MESSAGE and E_DEBUG_MESSAGE events, indexed by message id
+
+  int addPlayer(const std::string& name, const std::string& ai); //returns the new player id
+  int addMessage(const std::string& message); //returns the new message id
+};
+
+/*
+An Event is a plain struct of fixed size (it can be copied with memcpy). The names and messages
+are not in the event itself, but in the EventStrings of the game, and are only looked up (without
+copying them) when something asks for them with getPlayer, getAI or getMessage.
+*/
 struct Event
 {
   EventType type;
 
-  std::string player; //name of player the event is related to
-  std::string ai; //used for very rare events that unmistify the AI of a player
+  int playerId; //id of the player the event is related to, or -1 if none. The name is given by getPlayer().
   int chips; //money above call amount, if it's a raise event. Win amount if it's a win event. Pot amount if it's a pot event.
 
   int smallBlind;
   int bigBlind;
   int ante;
 
-  int position; //position for E_TOURNAMENT_WIN event
+  int position; //position for E_TOURNAMENT_RANK event
+
+  int messageId; //for E_LOG_MESSAGE and E_DEBUG_MESSAGE, the text is given by getMessage().
 
   //cards used for some event. Flop uses 3, turn uses card4, river uses card5, showdown and new_game uses card1 and card2. Win uses all 5.
   Card card1;
@@ -137,36 +176,127 @@ struct Event
   Card card4;
   Card card5;
 
+  const EventStrings* strings; //where the names and messages of the ids are. Set by the Game.
+
   Event(EventType type);
-  Event(EventType type, const std::string& player);
-  Event(EventType type, const std::string& player, int chips);
-  Event(EventType type, int position, const std::string& player);
-  Event(EventType type, int position, int chips, const std::string& player);
-  Event(EventType type, const std::string& player, const std::string& ai);
+  Event(EventType type, int playerId);
+  Event(EventType type, int playerId, int chips);
   Event(EventType type, const Card& card1);
   Event(EventType type, const Card& card1, const Card& card2);
   Event(EventType type, const Card& card1, const Card& card2, const Card& card3);
   Event(EventType type, const Card& card1, const Card& card2, const Card& card3, const Card& card4);
   Event(EventType type, const Card& card1, const Card& card2, const Card& card3, const Card& card4, const Card& card5);
-  Event(EventType type, const std::string& player, const Card& card1, const Card& card2, const Card& card3, const Card& card4, const Card& card5);
-  Event(EventType type, const std::string& player, const Card& card1, const Card& card2);
+  Event(EventType type, int playerId, const Card& card1, const Card& card2, const Card& card3, const Card& card4, const Card& card5);
+  Event(EventType type, int playerId, const Card& card1, const Card& card2);
   Event(EventType type, int smallBlind, int bigBlind, int ante);
-  Event(const std::string& message, EventType type);
-
 
-  std::string message;
+  bool hasPlayer() const;
+  const std::string& getPlayer() const; //name of the player the event is related to, empty if none
+  const std::string& getAI() const; //used for very rare events that unmistify the AI of a player (E_REVEAL_AI)
+  const std::string& getMessage() const; //text of E_LOG_MESSAGE and E_DEBUG_MESSAGE
 };
 
 //this gives the event in a good form for a log or computer parsing
 std::string eventToString(const Event& event);
 
+//same as eventToString, but appends it to out, e.g. to fill a big buffer without creating a string per event
+void appendEventString(std::string& out, const Event& event);
+
 //this gives the event in a more verbose full English sentence form
 std::string eventToStringVerbose(const Event& event);
 
-//TODO: make the opposite, a stringToEvent parsing function
+/*
+The opposite of eventToString: turns the lines of a log back into events, e.g. to calculate
+statistics from old logs. The parser keeps its own EventStrings, the player names get an id the
+first time they're seen. Parsing a line doesn't allocate memory (except for new player names), and
+the event it gives stays valid until the next line is parsed.
+
+The log doesn't say whose cards E_RECEIVE_CARDS are, so those events have no player, and the
+turn and river events get the earlier board cards of the deal from the parser.
+Lines that aren't an event the parser knows become E_LOG_MESSAGE, like they were written. A
+message of multiple lines comes back as one message per line.
+*/
+class EventParser
+{
+  private:
+    EventStrings strings;
+    std::unordered_map<std::string, int> playerIds; //by name
+    std::string key; //reused for looking up names
+    Card board[5]; //board cards of the current deal
+
+    int getPlayerId(const char* begin, const char* end);
+    bool parseEvent(Event& event, const char* begin, const char* end);
+
+  public:
+    EventParser();
 
-//sends unprocessed events to player, but only events the player is allowed to know! (the events vector is not supposed to contain personal events, such as E_RECEIVE_CARDS)
-void sendEventsToPlayers(size_t& counter, std::vector<Player>& players, std::vector<Observer*>& observers, const std::vector<Event>& events);
+    //parses one line (without the newline). Returns false if the line is no event: empty, or the title and date of a log.
+    bool parse(Event& event, const char* begin, const char* end);
+    bool parse(Event& event, const std::string& line);
+
+    const EventStrings& getStrings() const;
+};
+
+/*
+Event journal: writing all events of a game to a binary file, e.g. because the Game itself only
+keeps the events until they're sent. The file starts with "OOPEVTS1", followed by records
+that each start with one byte giving their kind:
+'P': a new player: int id, string name, string ai
+'M': a message: int id, string text (it comes right before the event that uses it)
+'E': an event: the 8 int fields of Event in the order of the struct, then the 5 cards as card index (-1 if unknown)
+All ints are 32-bit little endian, strings are an int length followed by the characters.
+*/
+class EventJournalWriter
+{
+  private:
+    std::ofstream file;
+    size_t numPlayers; //how many players of the EventStrings are already written
+
+    void writeInt(int value);
+    void writeString(const std::string& s);
+
+  public:
+    EventJournalWriter(const std::string& filename);
+    bool isOpen() const;
+    void write(const Event& event); //the event must have its strings set
+};
+
+class EventJournalReader
+{
+  private:
+    std::ifstream file;
+    EventStrings strings; //the events that are read point to this
+
+    bool readInt(int& value);
+    bool readString(std::string& s);
+
+  public:
+    EventJournalReader(const std::string& filename);
+    bool isOpen() const; //false if the file doesn't exist or isn't an event journal
+    bool read(Event& event); //reads the next event. Returns false if there are no more events in the file. The event stays valid as long as this reader.
+};
+
+/*
+Sends events to the players and observers, but only to those that want that type of event (see
+getEventMask), nothing at all is called on the others. And only events the player is allowed to know!
+(the events are not supposed to contain personal events, such as E_RECEIVE_CARDS)
+
+The lists of who wants which event type are made in setup, and must be made again when the
+players or observers change, since it keeps pointers to them.
+*/
+class EventDispatcher
+{
+  private:
+    std::vector<Player*> players[E_NUM_EVENTS];
+    std::vector<Observer*> observers[E_NUM_EVENTS];
+
+  public:
+    void setup(std::vector<Player>& players, std::vector<Observer*>& observers);
+    void send(const Event& event) const;
+
+    //sends the unprocessed events, from counter to the end, and sets counter to the end.
+    void send(size_t& counter, const std::vector<Event>& events) const;
+};
 
 
 
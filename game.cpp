@@ -25,6 +25,7 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #include "ai.h"
 #include "card.h"
 #include "deck.h"
+#include "enumerate.h"
 #include "combination.h"
 #include "event.h"
 #include "host.h"
@@ -38,32 +39,34 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #include "util.h"
 
 void makeInfo(Info& info, const Table& table, const Rules& rules, int playerViewPoint)
+{
+  info.players.resize(table.players.size());
+  for(size_t j = 0; j < table.players.size(); j++)
+  {
+    info.players[j].name = table.players[j].getName();
+  }
+  info.rules = rules;
+
+  updateInfo(info, table, playerViewPoint);
+}
+
+void updateInfo(Info& info, const Table& table, int playerViewPoint)
 {
   info.yourIndex = playerViewPoint;
   info.current = table.current;
   info.dealer = table.dealer;
   info.minRaiseAmount = table.lastRaiseAmount;
-  
-  info.boardCards.clear();
 
-  if(table.round >= R_FLOP)
-  {
-    info.boardCards.resize(3);
-    info.boardCards[0] = table.boardCard1;
-    info.boardCards[1] = table.boardCard2;
-    info.boardCards[2] = table.boardCard3;
-  }
-  if(table.round >= R_TURN)
-  {
-    info.boardCards.push_back(table.boardCard4);
-  }
-  if(table.round >= R_RIVER)
-  {
-    info.boardCards.push_back(table.boardCard5);
-  }
+  size_t numBoardCards = 0;
+  if(table.round >= R_FLOP) numBoardCards = 3;
+  if(table.round >= R_TURN) numBoardCards = 4;
+  if(table.round >= R_RIVER) numBoardCards = 5;
+  const Card* board[5] = { &table.boardCard1, &table.boardCard2, &table.boardCard3, &table.boardCard4, &table.boardCard5 };
+  info.boardCards.resize(numBoardCards); //never allocates, Info reserves room for 5 cards
+  for(size_t i = 0; i < numBoardCards; i++) info.boardCards[i] = *board[i];
+
   info.round = table.round;
   info.turn = table.turn;
-  info.players.resize(table.players.size());
   for(size_t j = 0; j < table.players.size(); j++)
   {
     PlayerInfo& p = info.players[j];
@@ -71,7 +74,6 @@ void makeInfo(Info& info, const Table& table, const Rules& rules, int playerView
     p.folded = pl.folded;
     p.stack = pl.stack;
     p.wager = pl.wager;
-    p.name = pl.getName();
     p.lastAction = pl.lastAction;
     p.showdown = pl.showdown;
     if(pl.showdown || (int)j == playerViewPoint)
@@ -82,7 +84,6 @@ void makeInfo(Info& info, const Table& table, const Rules& rules, int playerView
     }
     else p.holeCards.clear();
   }
-  info.rules = rules;
 }
 
 /*
@@ -136,11 +137,11 @@ void applyForcedBets(Table& table, const Rules& rules, std::vector<Event>& event
 
   int amount_sb = placeMoney(sb, rules.smallBlind);
 
-  events.push_back(Event(E_SMALL_BLIND, table.players[table.getSmallBlindIndex()].getName(), amount_sb));
+  events.push_back(Event(E_SMALL_BLIND, table.players[table.getSmallBlindIndex()].id, amount_sb));
 
   int amount_bb = placeMoney(bb, rules.bigBlind);
 
-  events.push_back(Event(E_BIG_BLIND, table.players[table.getBigBlindIndex()].getName(), amount_bb));
+  events.push_back(Event(E_BIG_BLIND, table.players[table.getBigBlindIndex()].id, amount_bb));
 
   if(rules.ante > 0)
   {
@@ -152,20 +153,20 @@ void applyForcedBets(Table& table, const Rules& rules, std::vector<Event>& event
 
       int amount = placeMoney(table.players[j], rules.ante);
 
-      events.push_back(Event(E_ANTE, table.players[table.getBigBlindIndex()].getName(), amount));
+      events.push_back(Event(E_ANTE, table.players[j].id, amount));
     }
   }
 }
 
 //the Info must be the information from BEFORE the player did the action (to determine bet<-->raise)
-Event eventFromAction(const Action& action, int callAmount, const std::string& playerName)
+Event eventFromAction(const Action& action, int callAmount, int playerId)
 {
   switch(action.command)
   {
-    case A_FOLD: return Event(E_FOLD, playerName);
-    case A_CHECK: return Event(E_CHECK, playerName);
-    case A_CALL: return Event(E_CALL, playerName);
-    case A_RAISE: return Event(E_RAISE, playerName, action.amount - callAmount);
+    case A_FOLD: return Event(E_FOLD, playerId);
+    case A_CHECK: return Event(E_CHECK, playerId);
+    case A_CALL: return Event(E_CALL, playerId);
+    case A_RAISE: return Event(E_RAISE, playerId, action.amount - callAmount);
     default: return Event(E_NUM_EVENTS);
   }
 
@@ -215,21 +216,9 @@ void getComboFromPlayerAndTable(Combination& combo, const Player& player, const
   getCombo(combo, cards);
 }
 
-/*
-Calculates how much each player gets from the pot, depending on each players wager, combination score and whether he's folded.
-Each std::vector has the size of the amount of players at the table and the index must match the index of players on the table.
-wins: how much chips each player gets.
-wager: how much each player has wagered this deal.
-score: the value of the best 5-card combination of each player, this is an integer that must be greater for a better combination.
-folded: whether or not this player is folded (folded players normally don't get any money, but may have bet some)
-*/
-void dividePot(std::vector<int>& wins, const std::vector<int>& wager, const std::vector<int>& score, const std::vector<bool>& folded)
+//splits the pot into the main pot and side pots, depending on the wager of each player
+static void getSidePots(std::vector<SidePot>& sidePots, const std::vector<int>& wager)
 {
-  wins.resize(wager.size()); //how much each player wins
-  for(size_t i = 0; i < wins.size(); i++) wins[i] = 0;
-
-  std::vector<SidePot> sidePots;
-
   int potsize = 0;
   std::vector<SPlayer> wagers;
   for(size_t i = 0; i < wager.size(); i++)
@@ -257,6 +246,23 @@ void dividePot(std::vector<int>& wins, const std::vector<int>& wager, const std:
      }
     wagerindex++;
   }
+}
+
+/*
+Calculates how much each player gets from the pot, depending on each players wager, combination score and whether he's folded.
+Each std::vector has the size of the amount of players at the table and the index must match the index of players on the table.
+wins: how much chips each player gets.
+wager: how much each player has wagered this deal.
+score: the value of the best 5-card combination of each player, this is an integer that must be greater for a better combination.
+folded: whether or not this player is folded (folded players normally don't get any money, but may have bet some)
+*/
+void dividePot(std::vector<int>& wins, const std::vector<int>& wager, const std::vector<int>& score, const std::vector<bool>& folded)
+{
+  wins.resize(wager.size()); //how much each player wins
+  for(size_t i = 0; i < wins.size(); i++) wins[i] = 0;
+
+  std::vector<SidePot> sidePots;
+  getSidePots(sidePots, wager);
 
   for(size_t j = 0; j < sidePots.size(); j++)
   {
@@ -285,6 +291,93 @@ void dividePot(std::vector<int>& wins, const std::vector<int>& wager, const std:
   } //for sidepots
 }
 
+/*
+Used by getExpectedPotDivision: called for every runout, with the unknown board cards
+filled in. Divides the side pots like dividePot does, but the chips of a split pot are
+shared exactly instead of giving the odd chips to one player.
+*/
+struct ExpectedPotDivider
+{
+  const std::vector<SidePot>& sidePots;
+  const std::vector<bool>& folded;
+  const std::vector<int>& hands; //eval7 indices, 2 per player
+  int* board; //the 5 board cards as eval7 indices
+  std::vector<int> score;
+  std::vector<double>& wins;
+  int count; //amount of runouts visited
+
+  ExpectedPotDivider(const std::vector<SidePot>& sidePots, const std::vector<bool>& folded, const std::vector<int>& hands, int* board, std::vector<double>& wins)
+  : sidePots(sidePots)
+  , folded(folded)
+  , hands(hands)
+  , board(board)
+  , score(folded.size())
+  , wins(wins)
+  , count(0)
+  {
+  }
+
+  void operator()(const int*)
+  {
+    int cards[7] = { board[0], board[1], board[2], board[3], board[4], 0, 0 };
+    for(size_t i = 0; i < score.size(); i++)
+    {
+      if(folded[i]) { score[i] = -1; continue; } //folded players can't gain money anymore, give lowest possible value
+      cards[5] = hands[i * 2];
+      cards[6] = hands[i * 2 + 1];
+      score[i] = eval7(cards);
+    }
+
+    for(size_t j = 0; j < sidePots.size(); j++)
+    {
+      const SidePot& p = sidePots[j];
+      int best = -2;
+      int num = 0; //num players with the best combination value
+      for(size_t i = 0; i < p.players.size(); i++)
+      {
+        int value = score[p.players[i]];
+        if(value > best) { best = value; num = 1; }
+        else if(value == best) num++;
+      }
+      double potdiv = (double)p.chips / num;
+      for(size_t i = 0; i < p.players.size(); i++)
+      {
+        if(score[p.players[i]] == best) wins[p.players[i]] += potdiv;
+      }
+    }
+
+    count++;
+  }
+};
+
+void getExpectedPotDivision(std::vector<double>& wins, const std::vector<int>& wager, const std::vector<bool>& folded
+                          , const std::vector<Card>& holeCards, const std::vector<Card>& boardCards)
+{
+  wins.assign(wager.size(), 0.0);
+
+  std::vector<SidePot> sidePots;
+  getSidePots(sidePots, wager);
+
+  int board[12]; //the 5 board cards. Larger because the enumeration is compiled for up to 7 cards at the end of it.
+  int numBoard = (int)boardCards.size();
+  for(int i = 0; i < numBoard; i++) board[i] = eval7_index(boardCards[i]);
+
+  std::vector<int> hands(wager.size() * 2, 0);
+  CardMask dead = cardsToMask(board, numBoard);
+  for(size_t i = 0; i < wager.size(); i++)
+  {
+    if(folded[i]) continue; //the cards of folded players are unknown, so they are not dead cards
+    hands[i * 2] = eval7_index(holeCards[i * 2]);
+    hands[i * 2 + 1] = eval7_index(holeCards[i * 2 + 1]);
+    dead |= cardToMask(hands[i * 2]) | cardToMask(hands[i * 2 + 1]);
+  }
+
+  ExpectedPotDivider divider(sidePots, folded, hands, board, wins);
+  enumerateKSubsets(5 - numBoard, CARDMASK_ALL & ~dead, &board[numBoard], divider);
+
+  for(size_t i = 0; i < wins.size(); i++) wins[i] /= divider.count;
+}
+
 void dividePot(Table& table, std::vector<Event>& events)
 {
   std::vector<Player>& players = table.players;
@@ -313,7 +406,7 @@ void dividePot(Table& table, std::vector<Event>& events)
   {
     if(wins[i] == 0) continue;
     players[i].stack += wins[i];
-    events.push_back(Event(E_WIN, players[i].getName(), wins[i]));
+    events.push_back(Event(E_WIN, players[i].id, wins[i]));
   }
 
   for(size_t i = 0; i < players.size(); i++)
@@ -432,6 +525,14 @@ Game::Game(Host* host)
 : host(host)
 , eventCounter(0)
 , numDeals(0)
+, infoSeatsChanged(true)
+, dispatcherChanged(true)
+, seeded(false)
+, seed(0)
+, numTables(0)
+, deckWriter(0)
+, deckReader(0)
+, eventJournal(0)
 {
 }
 
@@ -440,6 +541,83 @@ Game::~Game()
   //cleanup
   for(size_t i = 0; i < observers.size(); i++) delete observers[i];
   for(size_t i = 0; i < players.size(); i++) delete players[i].ai;
+  delete deckWriter;
+  delete deckReader;
+  delete eventJournal;
+}
+
+void Game::setSeed(uint64_t seed)
+{
+  this->seed = seed;
+  seeded = true;
+}
+
+bool Game::recordDecks(const std::string& filename)
+{
+  delete deckWriter;
+  deckWriter = new DeckWriter(filename);
+  return deckWriter->isOpen();
+}
+
+bool Game::journalEvents(const std::string& filename)
+{
+  delete eventJournal;
+  eventJournal = new EventJournalWriter(filename);
+  return eventJournal->isOpen();
+}
+
+bool Game::replayDecks(const std::string& filename)
+{
+  delete deckReader;
+  deckReader = new DeckReader(filename);
+  return deckReader->isOpen();
+}
+
+//the ids of the random streams of a table
+enum StreamPurpose
+{
+  STREAM_DECK,
+  STREAM_DEALER,
+  STREAM_AI,
+  STREAM_FAST //for seeding getRandomFast
+};
+
+static uint64_t getStreamId(int table, StreamPurpose purpose, int index)
+{
+  return ((uint64_t)table << 40) | ((uint64_t)purpose << 32) | (uint32_t)index;
+}
+
+void Game::initRandomStreams(Table& table)
+{
+  if(!seeded) return;
+
+  //deckRandom gets a stream per deal, in runTable
+  dealerRandom.seed(seed, getStreamId(numTables, STREAM_DEALER, 0));
+
+  aiRandom.resize(table.players.size());
+  for(size_t i = 0; i < table.players.size(); i++)
+  {
+    aiRandom[i].seed(seed, getStreamId(numTables, STREAM_AI, i));
+    table.players[i].random = &aiRandom[i];
+  }
+
+  RandomStream fast(seed, getStreamId(numTables, STREAM_FAST, 0));
+  seedRandomFast(fast.getUint(), fast.getUint());
+  clearEquityCache();
+}
+
+bool Game::shuffleDeck(Deck& deck)
+{
+  if(deckReader)
+  {
+    if(!deckReader->read(deck)) return false;
+  }
+  else
+  {
+    deck.shuffle();
+  }
+
+  return true;
 }
 
 //returns false if player wants to quit
@@ -470,7 +648,7 @@ void Game::settleBets(Table& table, Rules& rules)
 
     if(!isValidAction(action, player.stack, player.wager, table.getHighestWager(), table.lastRaiseAmount))
     {
-      events.push_back(Event("INVALID ACTION FROM " + player.getName() + " (" + valtostr(action.command) + " " + valtostr(action.amount) + ")", E_DEBUG_MESSAGE));
+      addMessageEvent("INVALID ACTION FROM " + player.getName() + " (" + valtostr(action.command) + " " + valtostr(action.amount) + ")", E_DEBUG_MESSAGE);
       action = Action(A_FOLD);
     }
 
@@ -485,7 +663,7 @@ void Game::settleBets(Table& table, Rules& rules)
     }
     else if(table.lastRaiser == -1 && (action.command == A_CALL || action.command == A_CHECK)) table.lastRaiser = table.current;
 
-    events.push_back(eventFromAction(action, callAmount, table.players[table.current].getName()));
+    events.push_back(eventFromAction(action, callAmount, table.players[table.current].id));
 
     applyAction(table, action, callAmount);
 
@@ -498,7 +676,34 @@ void Game::settleBets(Table& table, Rules& rules)
 
 void Game::sendEvents(Table& table)
 {
-  sendEventsToPlayers(eventCounter, table.players, table.observers, events);
+  for(size_t i = eventCounter; i < events.size(); i++) events[i].strings = &eventStrings;
+  if(dispatcherChanged)
+  {
+    dispatcher.setup(table.players, table.observers);
+    dispatcherChanged = false;
+  }
+  dispatcher.send(eventCounter, events);
+
+  //everyone got the events now, so they're only kept in the journal (if any), and the memory is reused for the next events. This keeps the memory use the same no matter how long the game runs.
+  if(eventJournal)
+  {
+    for(size_t i = 0; i < events.size(); i++) eventJournal->write(events[i]);
+  }
+  events.clear();
+  eventCounter = 0;
+  eventStrings.messages.clear();
+}
+
+void Game::flushObservers()
+{
+  for(size_t i = 0; i < observers.size(); i++) observers[i]->flush();
+}
+
+void Game::addMessageEvent(const std::string& message, EventType type)
+{
+  Event event(type);
+  event.messageId = eventStrings.addMessage(message);
+  events.push_back(event);
 }
 
 //all players who have no money left are kicked out or rebuy. Dealer is updated to be a non-out player.
@@ -512,7 +717,7 @@ void Game::kickOutPlayers(Table& table)
     {
       if(rules.allowRebuy)
       {
-        events.push_back(Event(E_REBUY, playersIn[i].getName(), rules.buyIn));
+        events.push_back(Event(E_REBUY, playersIn[i].id, rules.buyIn));
         playersIn[i].buyInTotal += rules.buyIn;
         playersIn[i].stack = rules.buyIn;
       }
@@ -523,16 +728,16 @@ void Game::kickOutPlayers(Table& table)
     }
     else if(playersIn[i].isHuman())
     {
-      Info info;
-      makeInfo(info, table, rules, i);
-      if(playersIn[i].ai->wantsToLeave(info)) leave = true;
+      if(playersIn[i].wantsToLeave(getInfoForPlayers(table, i))) leave = true;
     }
 
     if(leave)
     {
-      events.push_back(Event(E_QUIT, playersIn[i].getName(), playersIn[i].stack));
+      events.push_back(Event(E_QUIT, playersIn[i].id, playersIn[i].stack));
       playersOut.push_back(playersIn[i]);
       playersIn.erase(playersIn.begin() + i);
+      infoSeatsChanged = true;
+      dispatcherChanged = true;
       if(table.dealer > i) table.dealer--; // if i == table.dealer, it stays: that makes next player after the one who left the dealer
       if(table.dealer >= (int)playersIn.size()) table.dealer = 0; // if player at the end of array leaves. Dealer wraps around to 0.
       i--;
@@ -550,32 +755,48 @@ void Game::runTable(Table& table)
 
   for(size_t i = 0; i < table.players.size(); i++)
   {
-    events.push_back(Event(E_JOIN, table.players[i].getName(), table.players[i].stack));
+    events.push_back(Event(E_JOIN, table.players[i].id, table.players[i].stack));
   }
 
-  Deck deck;
+  Deck deck(seeded ? &deckRandom : 0);
+
+  initRandomStreams(table);
+  infoSeatsChanged = true;
+  dispatcherChanged = true;
 
   //table.dealer = -1; //so that player 0 will start at increment
-  table.dealer = getRandom(0, table.players.size() - 1);
+  table.dealer = seeded ? dealerRandom.get(0, table.players.size() - 1) : getRandom(0, table.players.size() - 1);
 
   bool table_running = true;
   while(table_running)
   {
+    if(!shuffleDeck(deck)) break; //end of the replayed deals
+
     numDeals++;
 
-    deck.shuffle();
+    /*
+    The cards are drawn when they're needed, but each deal has its own random stream. So how far a
+    deal gets doesn't change the cards of the later deals, and with a seed each deal gets the same
+    cards even if the AI's are different (see duplicate.h).
+    */
+    if(seeded) deckRandom.seed(seed, getStreamId(numTables, STREAM_DECK, numDeals));
 
     //give everyone the first and second card
     for(size_t i = 0; i < table.players.size(); i++) table.players[i].holeCard1 = deck.next();
     for(size_t i = 0; i < table.players.size(); i++) table.players[i].holeCard2 = deck.next();
 
-    for(size_t i = 0; i < table.players.size(); i++) table.players[i].onEvent(Event(E_RECEIVE_CARDS, table.players[i].getName(), table.players[i].holeCard1, table.players[i].holeCard2));
+    for(size_t i = 0; i < table.players.size(); i++)
+    {
+      Event event(E_RECEIVE_CARDS, table.players[i].id, table.players[i].holeCard1, table.players[i].holeCard2);
+      event.strings = &eventStrings;
+      table.players[i].onEvent(event);
+    }
 
     events.push_back(Event(E_NEW_DEAL, rules.smallBlind, rules.bigBlind, rules.ante));
     sendEvents(table);
     table.lastRaiseAmount = rules.bigBlind;
 
-    events.push_back(Event(E_DEALER, table.players[table.dealer].getName()));
+    events.push_back(Event(E_DEALER, table.players[table.dealer].id));
 
     applyForcedBets(table, rules, events);
 
@@ -637,27 +858,33 @@ void Game::runTable(Table& table)
       if(table.getNumActivePlayers() <= 1) show = false; //win by outbluffing everyone
       if(show)
       {
-        events.push_back(Event(E_PLAYER_SHOWDOWN, players[i].getName(), players[i].holeCard1, players[i].holeCard2));
+        events.push_back(Event(E_PLAYER_SHOWDOWN, players[i].id, players[i].holeCard1, players[i].holeCard2));
 
         players[i].showdown = true;//showdown (not if only one player left, in which case someone outbluffed everyone)
 
         Combination combo;
         getComboFromPlayerAndTable(combo, players[i], table);
-        events.push_back(Event(E_COMBINATION, players[i].getName(), combo.cards[0], combo.cards[1], combo.cards[2], combo.cards[3], combo.cards[4]));
+        events.push_back(Event(E_COMBINATION, players[i].id, combo.cards[0], combo.cards[1], combo.cards[2], combo.cards[3], combo.cards[4]));
       }
 
       if(!show)
       {
-        Info info;
-        makeInfo(info, table, rules, 0);
-        show = players[i].ai->boastCards(info);
-        if(show) events.push_back(Event(E_BOAST, players[i].getName(), players[i].holeCard1, players[i].holeCard2));
+        show = players[i].boastCards(getInfoForPlayers(table, 0));
+        if(show) events.push_back(Event(E_BOAST, players[i].id, players[i].holeCard1, players[i].holeCard2));
       }
     }
 
     dividePot(table, events);
 
+    if(deckWriter)
+    {
+      //the deck is shuffled lazily, so the order of the cards is only known once they're drawn. The rest is drawn too, so that a replay where the deal goes further gets the same cards. That doesn't change the later deals, they have their own stream.
+      while(deck.getNumLeft() > 0) deck.next();
+      deckWriter->write(deck);
+    }
+
     sendEvents(table);
+    flushObservers();
     host->onDealDone(getInfoForPlayers(table));
 
     for(size_t i = 0; i < players.size(); i++)
@@ -690,11 +917,14 @@ void Game::runTable(Table& table)
       table_running = false;
     }
   } //while table running
+
+  numTables++;
 }
 
 void Game::setRules(const Rules& rules)
 {
   this->rules = rules;
+  infoSeatsChanged = true;
 }
 
 bool playerGreaterForWin(const Player& a, const Player& b)
@@ -703,6 +933,13 @@ bool playerGreaterForWin(const Player& a, const Player& b)
 }
 
 
+static Event rankEvent(int playerId, int position, int score)
+{
+  Event event(E_TOURNAMENT_RANK, playerId, score);
+  event.position = position;
+  return event;
+}
+
 void Game::declareWinners(Table& table)
 {
   std::vector<Player> playerCopy = table.players;
@@ -713,22 +950,16 @@ void Game::declareWinners(Table& table)
   for(size_t i = 0; i < playerCopy.size(); i++)
   {
     if(pos == 1) std::cout << "Winner: " << playerCopy[0].getName() << " (AI: " << playerCopy[0].ai->getAIName() << ")" << std::endl;
-    events.push_back(Event(E_TOURNAMENT_RANK
-                         , pos
-                         , playerCopy[i].stack - playerCopy[i].buyInTotal
-                         , playerCopy[i].getName()));
-    events.push_back(Event(E_REVEAL_AI, playerCopy[i].getName(), playerCopy[i].getAIName()));
+    events.push_back(rankEvent(playerCopy[i].id, pos, playerCopy[i].stack - playerCopy[i].buyInTotal));
+    events.push_back(Event(E_REVEAL_AI, playerCopy[i].id));
     pos++;
   }
 
   for(size_t i = 0; i < playersOut.size(); i++)
   {
     size_t j = playersOut.size() - 1 - i;
-    events.push_back(Event(E_TOURNAMENT_RANK
-                         , pos
-                         , playersOut[j].stack - playersOut[j].buyInTotal
-                         , playersOut[j].getName()));
-    events.push_back(Event(E_REVEAL_AI, playersOut[j].getName(), playersOut[j].getAIName()));
+    events.push_back(rankEvent(playersOut[j].id, pos, playersOut[j].stack - playersOut[j].buyInTotal));
+    events.push_back(Event(E_REVEAL_AI, playersOut[j].id));
     pos++;
   }
 
@@ -736,7 +967,12 @@ void Game::declareWinners(Table& table)
 
 const Info& Game::getInfoForPlayers(Table& table, int viewPoint)
 {
-  makeInfo(infoForPlayers, table, rules, viewPoint);
+  if(infoSeatsChanged || infoForPlayers.players.size() != table.players.size())
+  {
+    makeInfo(infoForPlayers, table, rules, viewPoint);
+    infoSeatsChanged = false;
+  }
+  else updateInfo(infoForPlayers, table, viewPoint);
   return infoForPlayers;
 }
 
@@ -745,6 +981,7 @@ void Game::doGame()
   numDeals = 0;
   events.clear();
   eventCounter = 0;
+  dispatcherChanged = true;
 
   ObserverStatKeeper* o_stat_keeper = new ObserverStatKeeper();
   addObserver(o_stat_keeper);
@@ -763,7 +1000,7 @@ void Game::doGame()
   std::stringstream ss;
   ss << "The game begins. The AI's of the players are: " << std::endl;
   for(size_t i = 0; i < players.size(); i++) ss << table.players[i].getName() << ": " << table.players[i].ai->getAIName() << std::endl;
-  events.push_back(Event(ss.str(), E_LOG_MESSAGE));
+  addMessageEvent(ss.str(), E_LOG_MESSAGE);
 
   sendEvents(table);
 
@@ -778,15 +1015,18 @@ void Game::doGame()
 
   sendEvents(table);
 
+  flushObservers();
   host->onGameDone(getInfoForPlayers(table));
-  events.push_back(Event(statisticsToString(o_stat_keeper->getStatKeeper()), E_LOG_MESSAGE));
+  addMessageEvent(statisticsToString(o_stat_keeper->getStatKeeper()), E_LOG_MESSAGE);
 
   sendEvents(table);
+  flushObservers();
 }
 
 void Game::addPlayer(const Player& player)
 {
   players.push_back(player);
+  players.back().id = eventStrings.addPlayer(player.getName(), player.getAIName());
 }
 
 void Game::addObserver(Observer* observer)
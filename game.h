@@ -25,6 +25,7 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #include <vector>
 
 #include "info.h"
+#include "random.h"
 
 
 //forward declarations
@@ -33,10 +34,31 @@ class Table;
 struct Player;
 class Observer;
 struct Event;
+class Deck;
+class DeckWriter;
+class DeckReader;
+class EventJournalWriter;
 
 void makeInfo(Info& info, const Table& table, const Rules& rules, int playerViewPoint);
 
+/*
+Faster version of makeInfo for an Info that was made with makeInfo for the same table, and
+since then the players at the table didn't change. The names and the rules aren't copied
+again, and nothing is allocated: only the values that change during a deal are updated.
+*/
+void updateInfo(Info& info, const Table& table, int playerViewPoint);
+
 void dividePot(std::vector<int>& wins, const std::vector<int>& bet, const std::vector<int>& score, const std::vector<bool>& folded);
+
+/*
+The all-in equity: how much each player gets from the pot on average, over all possible runouts
+of the unknown board cards, with the pot divided as dividePot does. This is used to measure the
+result of a deal where everyone went all-in before the river without the luck of the runout.
+holeCards: 2 per player (in the same order as wager), only used for the players that didn't fold.
+boardCards: the known board cards (0, 3, 4 or 5)
+*/
+void getExpectedPotDivision(std::vector<double>& wins, const std::vector<int>& wager, const std::vector<bool>& folded
+                          , const std::vector<Card>& holeCards, const std::vector<Card>& boardCards);
 int getNumActivePlayers(const std::vector<Player>& players);
 bool betsSettled(int lastRaiseIndex, int current, int prev_current, const std::vector<Player>& players);
 
@@ -48,7 +70,8 @@ class Game
 
     std::vector<Player> players;
     std::vector<Observer*> observers;
-    std::vector<Event> events;
+    std::vector<Event> events; //the events that aren't sent yet to the players and observers. Cleared after sending.
+    EventStrings eventStrings; //the names and messages the events refer to
 
     size_t eventCounter;
     int numDeals; //how much deals are done since the game started
@@ -56,13 +79,33 @@ class Game
     Rules rules;
     
     Info infoForPlayers; //this is to speed up the game a lot, by not recreating the Info object everytime
+    bool infoSeatsChanged; //if true, infoForPlayers must be made again with makeInfo, otherwise updateInfo is enough
+
+    EventDispatcher dispatcher;
+    bool dispatcherChanged; //if true, the dispatcher must be set up again because the players or observers changed
+
+    //for reproducible games, see setSeed
+    bool seeded;
+    uint64_t seed;
+    int numTables; //how much tables are run so far, each table gets its own random streams
+    RandomStream deckRandom;
+    RandomStream dealerRandom;
+    std::vector<RandomStream> aiRandom; //one per player of the table
+
+    DeckWriter* deckWriter;
+    DeckReader* deckReader;
+    EventJournalWriter* eventJournal;
 
   protected:
     void settleBets(Table& table, Rules& rules);
     void kickOutPlayers(Table& table);
     void declareWinners(Table& table);
     void sendEvents(Table& table);
-    const Info& getInfoForPlayers(Table& table, int viewPoint = -1); //rather heavy-weight function! Copies entire Info object.
+    void addMessageEvent(const std::string& message, EventType type); //E_LOG_MESSAGE or E_DEBUG_MESSAGE
+    void flushObservers(); //at the end of each deal and of the game, see Observer::flush
+    const Info& getInfoForPlayers(Table& table, int viewPoint = -1); //updates infoForPlayers, only copies the player names and rules again if the players at the table changed
+    void initRandomStreams(Table& table);
+    bool shuffleDeck(Deck& deck); //returns false if a replayed recording has no more deals
 
   public:
 
@@ -74,6 +117,24 @@ class Game
     void addObserver(Observer* observer);
     void setRules(const Rules& rules);
 
+    /*
+    Makes the game reproducible: with the same seed, players, rules and deck file, a game is
+    replayed exactly. Each table gets its own random streams: one for the deck, one for choosing
+    the dealer, and one per AI (used while the AI has its turn or gets an event).
+    AI's that use getRandomFast get it seeded from the table stream too, and the equity cache is
+    cleared at the start of each table, so that its contents can't change the results.
+    */
+    void setSeed(uint64_t seed);
+
+    //Writes the card order of every deal to the file (see DeckWriter). Returns false if the file can't be created.
+    bool recordDecks(const std::string& filename);
+
+    //Writes all events of the game to the file (see EventJournalWriter), since the game itself doesn't keep them after sending them. Returns false if the file can't be created.
+    bool journalEvents(const std::string& filename);
+
+    //Deals the cards from a recorded file instead of shuffling. The table stops when the recorded deals run out. Returns false if the file can't be read.
+    bool replayDecks(const std::string& filename);
+
     void runTable(Table& table);
 
     void doGame();
@@ -0,0 +1,459 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "handrecord.h"
+
+#include "os.h"
+#include "util.h"
+
+#include <cstring>
+#include <sstream>
+
+#if defined(OS_LINUX) || defined(OS_UNKNOWN)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HANDRECORD_MMAP
+#endif
+
+static const char HR_MAGIC[] = "OOPHANDS";
+static const int HR_VERSION = 1;
+
+int getHandRecordColumnSize(int column)
+{
+  switch(column)
+  {
+    case HRC_NUM_SEATS: return 1;
+    case HRC_DEALER: return 1;
+    case HRC_BIG_BLIND: return 4;
+    case HRC_POT: return 4;
+    case HRC_BOARD: return 5;
+    case HRC_PLAYER: return 4 * HR_MAX_SEATS;
+    case HRC_STACK: return 4 * HR_MAX_SEATS;
+    case HRC_HOLE: return 2 * HR_MAX_SEATS;
+    case HRC_ACTIONS: return HR_MAX_SEATS * HR_NUM_STREETS;
+    case HRC_AMOUNTS: return 4 * HR_MAX_SEATS * HR_NUM_STREETS;
+    case HRC_WON: return 4 * HR_MAX_SEATS;
+    case HRC_SHOWDOWN: return HR_MAX_SEATS;
+    default: return 0;
+  }
+}
+
+//where the value of the column is in the HandRecord struct
+static const void* getColumnInRecord(const HandRecord& r, int column)
+{
+  switch(column)
+  {
+    case HRC_NUM_SEATS: return &r.numSeats;
+    case HRC_DEALER: return &r.dealer;
+    case HRC_BIG_BLIND: return &r.bigBlind;
+    case HRC_POT: return &r.pot;
+    case HRC_BOARD: return r.board;
+    case HRC_PLAYER: return r.player;
+    case HRC_STACK: return r.stack;
+    case HRC_HOLE: return r.hole;
+    case HRC_ACTIONS: return r.actions;
+    case HRC_AMOUNTS: return r.amounts;
+    case HRC_WON: return r.won;
+    case HRC_SHOWDOWN: return r.showdown;
+    default: return 0;
+  }
+}
+
+static size_t pad8(size_t size)
+{
+  return (size + 7) & ~(size_t)7;
+}
+
+HandRecord::HandRecord()
+{
+  std::memset(this, 0, sizeof(HandRecord));
+  std::memset(board, HR_NO_CARD, sizeof(board));
+  std::memset(hole, HR_NO_CARD, sizeof(hole));
+  for(int i = 0; i < HR_MAX_SEATS; i++) player[i] = -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void appendInt(std::vector<unsigned char>& out, int value)
+{
+  for(int i = 0; i < 4; i++) out.push_back((unsigned char)(((unsigned)value >> (i * 8)) & 255));
+}
+
+static void appendString(std::vector<unsigned char>& out, const std::string& s)
+{
+  appendInt(out, (int)s.size());
+  out.insert(out.end(), s.begin(), s.end());
+}
+
+//fills in the size of the chunk that started at begin, and pads it
+static void finishChunk(std::vector<unsigned char>& out, size_t begin)
+{
+  out.resize(begin + pad8(out.size() - begin), 0);
+  int size = (int)(out.size() - begin - 8);
+  for(int i = 0; i < 4; i++) out[begin + 4 + i] = (unsigned char)((size >> (i * 8)) & 255);
+}
+
+HandRecordWriter::HandRecordWriter(const std::string& filename)
+{
+  file = fopen(filename.c_str(), "wb");
+  records.reserve(BLOCK_RECORDS);
+  if(!file) return;
+
+  data.clear();
+  for(int i = 0; i < 8; i++) data.push_back(HR_MAGIC[i]);
+  appendInt(data, HR_VERSION);
+  appendInt(data, HRC_NUM_COLUMNS);
+  for(int c = 0; c < HRC_NUM_COLUMNS; c++)
+  {
+    appendInt(data, c);
+    appendInt(data, getHandRecordColumnSize(c));
+  }
+  data.resize(pad8(data.size()), 0);
+  fwrite(&data[0], 1, data.size(), file);
+}
+
+HandRecordWriter::~HandRecordWriter()
+{
+  if(!file) return;
+  writeBlock();
+  fclose(file);
+}
+
+bool HandRecordWriter::isOpen() const
+{
+  return file != 0;
+}
+
+void HandRecordWriter::addPlayer(int id, const std::string& name, const std::string& ai)
+{
+  if(!file) return;
+  data.clear();
+  appendInt(data, 'P');
+  appendInt(data, 0);
+  appendInt(data, id);
+  appendString(data, name);
+  appendString(data, ai);
+  finishChunk(data, 0);
+  fwrite(&data[0], 1, data.size(), file);
+}
+
+void HandRecordWriter::write(const HandRecord& record)
+{
+  if(!file) return;
+  records.push_back(record);
+  if(records.size() >= BLOCK_RECORDS) writeBlock();
+}
+
+void HandRecordWriter::writeBlock()
+{
+  if(records.empty()) return;
+
+  data.clear();
+  appendInt(data, 'B');
+  appendInt(data, 0);
+  appendInt(data, (int)records.size());
+  appendInt(data, 0);
+  for(int c = 0; c < HRC_NUM_COLUMNS; c++)
+  {
+    size_t columnSize = getHandRecordColumnSize(c);
+    size_t begin = data.size();
+    data.resize(begin + pad8(columnSize * records.size()), 0);
+    for(size_t i = 0; i < records.size(); i++)
+    {
+      std::memcpy(&data[begin + i * columnSize], getColumnInRecord(records[i], c), columnSize);
+    }
+  }
+  finishChunk(data, 0);
+  fwrite(&data[0], 1, data.size(), file);
+
+  records.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static int readInt(const unsigned char* p)
+{
+  return (int)(p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned)p[3] << 24));
+}
+
+HandRecordFile::HandRecordFile()
+: data(0)
+, size(0)
+, mapped(false)
+{
+}
+
+HandRecordFile::~HandRecordFile()
+{
+  close();
+}
+
+void HandRecordFile::close()
+{
+#if defined(HANDRECORD_MMAP)
+  if(mapped) munmap((void*)data, size);
+#endif
+  data = 0;
+  size = 0;
+  mapped = false;
+  buffer.clear();
+  blocks.clear();
+  players.clear();
+  ais.clear();
+}
+
+bool HandRecordFile::open(const std::string& filename)
+{
+  close();
+
+#if defined(HANDRECORD_MMAP)
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if(fd < 0) return false;
+  struct stat st;
+  if(fstat(fd, &st) == 0 && st.st_size > 0)
+  {
+    void* p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(p != MAP_FAILED)
+    {
+      data = (const unsigned char*)p;
+      size = st.st_size;
+      mapped = true;
+      madvise(p, size, MADV_SEQUENTIAL);
+    }
+  }
+  ::close(fd);
+#endif
+
+  if(!mapped)
+  {
+    FILE* f = fopen(filename.c_str(), "rb");
+    if(!f) return false;
+    unsigned char chunk[65536];
+    size_t n;
+    while((n = fread(chunk, 1, sizeof(chunk), f)) > 0) buffer.insert(buffer.end(), chunk, chunk + n);
+    fclose(f);
+    if(buffer.empty()) return false;
+    data = &buffer[0];
+    size = buffer.size();
+  }
+
+  if(!parse())
+  {
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool HandRecordFile::parse()
+{
+  if(size < 16 || std::memcmp(data, HR_MAGIC, 8) != 0) return false;
+  if(readInt(data + 8) != HR_VERSION) return false;
+  int numColumns = readInt(data + 12);
+  if(numColumns < 0 || 16 + (size_t)numColumns * 8 > size) return false;
+
+  std::vector<int> ids(numColumns);
+  std::vector<size_t> sizes(numColumns);
+  for(int c = 0; c < numColumns; c++)
+  {
+    ids[c] = readInt(data + 16 + c * 8);
+    sizes[c] = (size_t)readInt(data + 20 + c * 8);
+    if(ids[c] >= 0 && ids[c] < HRC_NUM_COLUMNS && (int)sizes[c] != getHandRecordColumnSize(ids[c])) return false;
+  }
+
+  size_t pos = pad8(16 + numColumns * 8);
+  while(pos < size)
+  {
+    if(size - pos < 8) return false;
+    int kind = readInt(data + pos);
+    size_t chunkSize = (size_t)readInt(data + pos + 4);
+    pos += 8;
+    if(chunkSize > size - pos) return false;
+    const unsigned char* p = data + pos;
+
+    if(kind == 'P')
+    {
+      if(chunkSize < 12) return false;
+      int id = readInt(p);
+      size_t nameLength = (size_t)readInt(p + 4);
+      if(id < 0 || nameLength > chunkSize - 12) return false;
+      size_t aiLength = (size_t)readInt(p + 8 + nameLength);
+      if(aiLength > chunkSize - 12 - nameLength) return false;
+      if((int)players.size() <= id)
+      {
+        players.resize(id + 1);
+        ais.resize(id + 1);
+      }
+      players[id].assign((const char*)p + 8, nameLength);
+      ais[id].assign((const char*)p + 12 + nameLength, aiLength);
+    }
+    else if(kind == 'B')
+    {
+      if(chunkSize < 8) return false;
+      HandRecordBlock block;
+      block.numRecords = (size_t)readInt(p);
+      for(int c = 0; c < HRC_NUM_COLUMNS; c++) block.columns[c] = 0;
+      size_t offset = 8;
+      for(int c = 0; c < numColumns; c++)
+      {
+        size_t columnBytes = pad8(sizes[c] * block.numRecords);
+        if(columnBytes > chunkSize - offset) return false;
+        if(ids[c] >= 0 && ids[c] < HRC_NUM_COLUMNS) block.columns[ids[c]] = p + offset;
+        offset += columnBytes;
+      }
+      for(int c = 0; c < HRC_NUM_COLUMNS; c++) if(!block.columns[c]) return false; //all columns of this version are needed
+      blocks.push_back(block);
+    }
+
+    pos += chunkSize;
+  }
+
+  return true;
+}
+
+size_t HandRecordFile::getNumRecords() const
+{
+  size_t result = 0;
+  for(size_t i = 0; i < blocks.size(); i++) result += blocks[i].numRecords;
+  return result;
+}
+
+const std::string& HandRecordFile::getPlayerName(int id) const
+{
+  static const std::string empty;
+  return id >= 0 && id < (int)players.size() ? players[id] : empty;
+}
+
+const std::string& HandRecordFile::getPlayerAI(int id) const
+{
+  static const std::string empty;
+  return id >= 0 && id < (int)ais.size() ? ais[id] : empty;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+HandRecordFilter::HandRecordFilter()
+: numSeats(0)
+, minPot(0)
+{
+}
+
+HandRecordStats::HandRecordStats()
+: deals(0)
+, vpip(0)
+, pfr(0)
+, flops(0)
+, showdowns(0)
+, showdowns_won(0)
+, chips_won(0)
+, chips_lost(0)
+{
+  for(int i = 0; i < HR_MAX_SEATS; i++)
+  {
+    deals_position[i] = 0;
+    vpip_position[i] = 0;
+  }
+}
+
+void queryHandRecords(std::vector<HandRecordStats>& stats, const HandRecordFile& file, const HandRecordFilter& filter)
+{
+  stats.clear();
+  stats.resize(file.getNumPlayerIds());
+  for(size_t i = 0; i < stats.size(); i++)
+  {
+    stats[i].name = file.getPlayerName((int)i);
+    stats[i].ai = file.getPlayerAI((int)i);
+  }
+
+  for(size_t b = 0; b < file.getNumBlocks(); b++)
+  {
+    const HandRecordBlock& block = file.getBlock(b);
+    for(size_t r = 0; r < block.numRecords; r++)
+    {
+      int numSeats = block.getNumSeats(r);
+      if(filter.numSeats > 0 && numSeats != filter.numSeats) continue;
+      if(block.getPot(r) < filter.minPot) continue;
+      int dealer = block.getDealer(r);
+
+      for(int seat = 0; seat < numSeats && seat < HR_MAX_SEATS; seat++)
+      {
+        int id = block.getPlayer(r, seat);
+        if(id < 0) continue;
+        if(id >= (int)stats.size()) stats.resize(id + 1);
+        HandRecordStats& s = stats[id];
+
+        int position = (seat - dealer + numSeats) % numSeats;
+        unsigned char preflop = block.getActions(r, seat, 0);
+        bool vpip = (preflop & (HR_CALL | HR_BET | HR_RAISE)) != 0;
+        int won = block.getWon(r, seat);
+
+        s.deals++;
+        s.deals_position[position]++;
+        if(vpip)
+        {
+          s.vpip++;
+          s.vpip_position[position]++;
+        }
+        if(preflop & (HR_BET | HR_RAISE)) s.pfr++;
+        if((preflop & HR_FOLD) == 0 && block.getBoard(r, 0) != HR_NO_CARD) s.flops++;
+        if(block.getShowdown(r, seat))
+        {
+          s.showdowns++;
+          if(won > 0) s.showdowns_won++;
+        }
+        s.chips_won += won;
+        for(int street = 0; street < HR_NUM_STREETS; street++) s.chips_lost += block.getAmount(r, seat, street);
+      }
+    }
+  }
+}
+
+static double divide(int a, int b)
+{
+  return b == 0 ? 0.0 : (double)a / b;
+}
+
+std::string handRecordStatsToString(const std::vector<HandRecordStats>& stats)
+{
+  std::stringstream ss;
+  for(size_t i = 0; i < stats.size(); i++)
+  {
+    const HandRecordStats& s = stats[i];
+    if(s.deals == 0) continue;
+    ss << "Player: " << s.name;
+    if(!s.ai.empty()) ss << " (AI: " << s.ai << ")";
+    ss << std::endl;
+    ss << "deals: " << s.deals << ", VP$IP: " << divide(s.vpip, s.deals) << ", PFR: " << divide(s.pfr, s.deals)
+       << ", flops seen: " << divide(s.flops, s.deals) << std::endl;
+    ss << "WSD: " << divide(s.showdowns, s.deals) << ", WSDW: " << divide(s.showdowns_won, s.showdowns)
+       << ", chips won: " << s.chips_won << ", chips lost: " << s.chips_lost << std::endl;
+    ss << "VP$IP by position (0 = dealer):";
+    for(int p = 0; p < HR_MAX_SEATS; p++)
+    {
+      if(s.deals_position[p] > 0) ss << " " << p << ": " << divide(s.vpip_position[p], s.deals_position[p]);
+    }
+    ss << std::endl << std::endl;
+  }
+  return ss.str();
+}
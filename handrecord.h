@@ -0,0 +1,215 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+Hand records: a compact binary file with one fixed size record per deal, so that statistics over
+very many deals can be calculated without parsing text logs. ObserverHandRecord writes them during
+a game, HandRecordFile reads them back.
+
+The records are stored per column: the records are grouped in blocks, and in a block first the
+values of column 0 of all records are stored, then those of column 1, etc... That way a query only
+reads the columns it needs, and reads them as one big contiguous array.
+
+The seats are in the order of the table, with the dealer at seat "dealer". The position of a seat,
+counted clockwise from the dealer, is (seat - dealer + numSeats) % numSeats, so 0 is the button.
+Cards are given as card index (see Card::getIndex), or HR_NO_CARD if not known. Observers only see
+the hole cards of a player if they're shown.
+
+File format (all ints 32-bit little endian, all sizes padded to multiples of 8 bytes):
+-"OOPHANDS", int version (1), int number of columns, then per column: int column id, int bytes per record
+-then chunks, each: int kind, int size of the data after this, then the data. The kinds are:
+  'P' (player): int id, int length, the name, int length, the AI name (if known)
+  'B' (block): int number of records, int 0, then the columns in the order of the header, each padded
+Readers must skip chunks of a kind they don't know.
+*/
+
+enum { HR_MAX_SEATS = 10, HR_NUM_STREETS = 4 };
+
+static const unsigned char HR_NO_CARD = 255;
+
+//the action bits of a seat for one street (pre-flop, flop, turn, river). Multiple bits can be set, e.g. check, then call.
+enum
+{
+  HR_FOLD = 1,
+  HR_CHECK = 2,
+  HR_CALL = 4,
+  HR_BET = 8,
+  HR_RAISE = 16,
+  HR_ALLIN = 32,
+  HR_BLIND = 64 //small blind, big blind or ante
+};
+
+enum HandRecordColumn
+{
+  HRC_NUM_SEATS, //unsigned char
+  HRC_DEALER, //unsigned char: seat of the dealer
+  HRC_BIG_BLIND, //int
+  HRC_POT, //int: total pot
+  HRC_BOARD, //unsigned char[5]
+  HRC_PLAYER, //int[HR_MAX_SEATS]: player id, -1 for no player
+  HRC_STACK, //int[HR_MAX_SEATS]: stack at the start of the deal
+  HRC_HOLE, //unsigned char[HR_MAX_SEATS][2]
+  HRC_ACTIONS, //unsigned char[HR_MAX_SEATS][HR_NUM_STREETS]: HR_FOLD, ... bits
+  HRC_AMOUNTS, //int[HR_MAX_SEATS][HR_NUM_STREETS]: chips put in the pot in that street
+  HRC_WON, //int[HR_MAX_SEATS]: chips won from the pot
+  HRC_SHOWDOWN, //unsigned char[HR_MAX_SEATS]: 1 if the seat went to the showdown
+  HRC_NUM_COLUMNS
+};
+
+int getHandRecordColumnSize(int column); //bytes per record
+
+//one deal, as filled in by ObserverHandRecord
+struct HandRecord
+{
+  HandRecord();
+
+  unsigned char numSeats;
+  unsigned char dealer;
+  int bigBlind;
+  int pot;
+  unsigned char board[5];
+  int player[HR_MAX_SEATS];
+  int stack[HR_MAX_SEATS];
+  unsigned char hole[HR_MAX_SEATS][2];
+  unsigned char actions[HR_MAX_SEATS][HR_NUM_STREETS];
+  int amounts[HR_MAX_SEATS][HR_NUM_STREETS];
+  int won[HR_MAX_SEATS];
+  unsigned char showdown[HR_MAX_SEATS];
+};
+
+class HandRecordWriter
+{
+  private:
+    FILE* file;
+    std::vector<HandRecord> records; //the block that isn't written yet
+    std::vector<unsigned char> data; //the chunk being written
+
+    void writeBlock();
+
+  public:
+    static const size_t BLOCK_RECORDS = 4096;
+
+    HandRecordWriter(const std::string& filename); //overwrites the file
+    ~HandRecordWriter(); //writes the last, partial, block
+
+    bool isOpen() const;
+    void addPlayer(int id, const std::string& name, const std::string& ai);
+    void write(const HandRecord& record);
+};
+
+//a block of records as it is in the file: one pointer per column, to numRecords values
+struct HandRecordBlock
+{
+  size_t numRecords;
+  const unsigned char* columns[HRC_NUM_COLUMNS]; //null if the file doesn't have that column
+
+  unsigned char getNumSeats(size_t record) const { return columns[HRC_NUM_SEATS][record]; }
+  unsigned char getDealer(size_t record) const { return columns[HRC_DEALER][record]; }
+  int getBigBlind(size_t record) const { return getInt(HRC_BIG_BLIND, record); }
+  int getPot(size_t record) const { return getInt(HRC_POT, record); }
+  unsigned char getBoard(size_t record, int i) const { return columns[HRC_BOARD][record * 5 + i]; }
+  int getPlayer(size_t record, int seat) const { return getInt(HRC_PLAYER, record * HR_MAX_SEATS + seat); }
+  int getStack(size_t record, int seat) const { return getInt(HRC_STACK, record * HR_MAX_SEATS + seat); }
+  unsigned char getHole(size_t record, int seat, int i) const { return columns[HRC_HOLE][(record * HR_MAX_SEATS + seat) * 2 + i]; }
+  unsigned char getActions(size_t record, int seat, int street) const { return columns[HRC_ACTIONS][(record * HR_MAX_SEATS + seat) * HR_NUM_STREETS + street]; }
+  int getAmount(size_t record, int seat, int street) const { return getInt(HRC_AMOUNTS, (record * HR_MAX_SEATS + seat) * HR_NUM_STREETS + street); }
+  int getWon(size_t record, int seat) const { return getInt(HRC_WON, record * HR_MAX_SEATS + seat); }
+  bool getShowdown(size_t record, int seat) const { return columns[HRC_SHOWDOWN][record * HR_MAX_SEATS + seat] != 0; }
+
+  //the file is little endian, like the computers this runs on, so the ints are read directly
+  int getInt(int column, size_t index) const { return ((const int*)columns[column])[index]; }
+};
+
+/*
+Reads a hand record file. The file is memory mapped (where the OS supports it, otherwise it's
+read into memory), and the blocks point straight into it, so opening even a huge file is fast and
+the queries read the columns at the speed of memory.
+*/
+class HandRecordFile
+{
+  private:
+    const unsigned char* data;
+    size_t size;
+    std::vector<unsigned char> buffer; //only used if the file isn't memory mapped
+    bool mapped;
+
+    std::vector<HandRecordBlock> blocks;
+    std::vector<std::string> players; //names by player id
+    std::vector<std::string> ais; //AI names by player id
+
+    bool parse();
+    void close();
+
+  public:
+    HandRecordFile();
+    ~HandRecordFile();
+
+    bool open(const std::string& filename); //returns false if the file can't be read or isn't a valid hand record file
+
+    size_t getNumBlocks() const { return blocks.size(); }
+    const HandRecordBlock& getBlock(size_t i) const { return blocks[i]; }
+    size_t getNumRecords() const;
+
+    const std::string& getPlayerName(int id) const;
+    const std::string& getPlayerAI(int id) const;
+    int getNumPlayerIds() const { return (int)players.size(); }
+};
+
+//which deals a query uses
+struct HandRecordFilter
+{
+  HandRecordFilter();
+
+  int numSeats; //only deals with this many players at the table, 0 for all
+  int minPot; //only deals with at least this pot
+};
+
+//statistics of one player over the deals of a query
+struct HandRecordStats
+{
+  HandRecordStats();
+
+  std::string name;
+  std::string ai;
+
+  int deals;
+  int vpip; //deals in which the player voluntarily called, bet or raised pre-flop
+  int pfr; //deals in which the player bet or raised pre-flop
+  int deals_position[HR_MAX_SEATS]; //deals per position (0 = dealer, see the hand record file format)
+  int vpip_position[HR_MAX_SEATS];
+  int flops; //deals in which the player saw the flop
+  int showdowns; //deals in which the player went to the showdown
+  int showdowns_won; //showdowns in which the player won (part of) the pot
+  long long chips_won; //total chips won from pots
+  long long chips_lost; //total chips put in pots
+};
+
+//calculates the statistics of all players in the file, indexed by player id
+void queryHandRecords(std::vector<HandRecordStats>& stats, const HandRecordFile& file, const HandRecordFilter& filter);
+
+std::string handRecordStatsToString(const std::vector<HandRecordStats>& stats);
@@ -0,0 +1,128 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "host_headless.h"
+
+#include "event.h"
+
+#include <sstream>
+
+//counts the decisions of the players for HostHeadless
+class ObserverHeadless : public Observer
+{
+  private:
+    HostHeadless* host;
+
+  public:
+    ObserverHeadless(HostHeadless* host) : host(host) {}
+
+    virtual void onEvent(const Event& event)
+    {
+      (void)event;
+      host->onDecision();
+    }
+
+    virtual EventMask getEventMask() const
+    {
+      return eventMask(E_FOLD) | eventMask(E_CHECK) | eventMask(E_CALL) | eventMask(E_RAISE);
+    }
+};
+
+HostHeadless::HostHeadless()
+: quit(false)
+, deals(0)
+, decisions(0)
+, startTime(std::chrono::steady_clock::now())
+, endTime(startTime)
+{
+}
+
+void HostHeadless::onFrame()
+{
+}
+
+void HostHeadless::onGameBegin(const Info& info)
+{
+  (void)info;
+  startTime = endTime = std::chrono::steady_clock::now();
+}
+
+void HostHeadless::onDealDone(const Info& info)
+{
+  (void)info;
+  deals++;
+}
+
+void HostHeadless::onGameDone(const Info& info)
+{
+  (void)info;
+  endTime = std::chrono::steady_clock::now();
+}
+
+bool HostHeadless::wantToQuit() const
+{
+  return quit;
+}
+
+void HostHeadless::resetWantToQuit()
+{
+  quit = false;
+}
+
+Observer* HostHeadless::createObserver()
+{
+  return new ObserverHeadless(this);
+}
+
+void HostHeadless::onDecision()
+{
+  decisions++;
+}
+
+long long HostHeadless::getNumDeals() const
+{
+  return deals;
+}
+
+long long HostHeadless::getNumDecisions() const
+{
+  return decisions;
+}
+
+double HostHeadless::getSeconds() const
+{
+  std::chrono::steady_clock::time_point end = endTime;
+  if(end == startTime) end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - startTime).count();
+}
+
+std::string HostHeadless::getThroughputString() const
+{
+  double seconds = getSeconds();
+  if(seconds <= 0.0) seconds = 1e-9;
+
+  std::stringstream ss;
+  ss << "deals: " << deals << ", decisions: " << decisions << ", seconds: " << seconds
+     << ", deals/sec: " << deals / seconds << ", decisions/sec: " << decisions / seconds;
+  return ss.str();
+}
@@ -0,0 +1,72 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "host.h"
+#include "observer.h"
+
+#include <chrono>
+#include <string>
+
+/*
+Implementation of Host without any terminal input or output, for running many deals of
+AI battles unattended as fast as possible. It never quits on its own, so the game should
+end through the rules (fixed number of deals, or last remaining).
+
+It keeps track of how many deals and decisions are done and how long that took. For counting
+the decisions, add the observer from createObserver to the game.
+*/
+class HostHeadless : public Host
+{
+  private:
+    bool quit;
+
+    long long deals;
+    long long decisions;
+
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point endTime;
+
+  public:
+
+    HostHeadless();
+
+    virtual void onFrame(); //called between every player decision
+    virtual void onGameBegin(const Info& info); //called after all players are sitting at the table, right before the first deal starts
+    virtual void onDealDone(const Info& info);
+    virtual void onGameDone(const Info& info); //when the whole tournament is done
+
+    virtual bool wantToQuit() const;
+    virtual void resetWantToQuit();
+
+    //not part of the Host interface
+    Observer* createObserver(); //observer that counts the decisions for this host. The game deletes it.
+    void onDecision();
+
+    long long getNumDeals() const;
+    long long getNumDecisions() const;
+    double getSeconds() const; //time from the begin to the end of the game (or until now if it's still running)
+
+    std::string getThroughputString() const; //deals and decisions per second
+};
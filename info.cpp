@@ -28,6 +28,7 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 PlayerInfo::PlayerInfo()
 : showdown(false)
 {
+  holeCards.reserve(2); //so that updating the Info for each decision doesn't allocate memory
 }
 
 const std::string& PlayerInfo::getName() const
@@ -57,6 +58,7 @@ bool PlayerInfo::canDecide() const
 
 Info::Info()
 {
+  boardCards.reserve(5); //so that updating the Info for each decision doesn't allocate memory
 }
 
 const std::vector<Card>& Info::getHoleCards() const
@@ -320,7 +322,7 @@ double Info::getPotEquity(int index) const
 {
   int numOpponents = getNumActivePlayers() - 1;
 
-  return ::getPotEquity(getHoleCards(index), boardCards, numOpponents);
+  return getPotEquityCached(getHoleCards(index), boardCards, numOpponents);
 }
 
 int Info::getPosition(int index) const
@@ -332,3 +334,222 @@ const std::vector<Card>& Info::getHoleCards(int index) const
 {
   return players[index].holeCards;
 }
+
+InfoKeeper::InfoKeeper(const Rules& rules)
+: yourId(-1)
+{
+  info.yourIndex = -1;
+  info.dealer = 0;
+  info.current = -1;
+  info.round = R_PRE_FLOP;
+  info.turn = 0;
+  info.minRaiseAmount = rules.bigBlind;
+  info.rules = rules;
+}
+
+const Info& InfoKeeper::getInfo() const
+{
+  return info;
+}
+
+EventMask InfoKeeper::getEventMask()
+{
+  EventMask result = 0;
+  EventType types[] = { E_JOIN, E_QUIT, E_REBUY, E_SMALL_BLIND, E_BIG_BLIND, E_ANTE, E_FOLD, E_CHECK, E_CALL, E_RAISE, E_NEW_DEAL,
+                        E_RECEIVE_CARDS, E_FLOP, E_TURN, E_RIVER, E_SHOWDOWN, E_POT_DIVISION, E_PLAYER_SHOWDOWN, E_WIN, E_DEALER };
+  for(size_t i = 0; i < sizeof(types) / sizeof(*types); i++) result |= eventMask(types[i]);
+  return result;
+}
+
+int InfoKeeper::getIndex(const Event& event) const
+{
+  for(size_t i = 0; i < ids.size(); i++) //there are at most 10 players at a table
+  {
+    if(ids[i] == event.playerId) return i;
+  }
+  return -1;
+}
+
+int InfoKeeper::getInitialPlayer() const
+{
+  //the same as getInitialPlayer in game.cpp, but for the Info
+  int num = info.getNumPlayers();
+  if(num < 2 || info.getNumDecidingPlayers() < 2) return -1;
+  int index;
+  if(num == 2) index = info.round == R_PRE_FLOP ? info.dealer : info.dealer + 1;
+  else index = info.round == R_PRE_FLOP ? info.dealer + 3 : info.dealer + 1;
+  index = info.wrap(index);
+  if(info.players[index].canDecide()) return index;
+  return getNextPlayer(index);
+}
+
+int InfoKeeper::getNextPlayer(int index) const
+{
+  int num = info.getNumPlayers();
+  for(int i = 1; i < num; i++)
+  {
+    int j = info.wrap(index + i);
+    if(info.players[j].canDecide()) return j;
+  }
+  return -1;
+}
+
+void InfoKeeper::placeMoney(PlayerInfo& player, int amount)
+{
+  if(amount > player.stack) amount = player.stack;
+  player.stack -= amount;
+  player.wager += amount;
+}
+
+void InfoKeeper::onEvent(const Event& event)
+{
+  int index = event.hasPlayer() ? getIndex(event) : -1;
+  PlayerInfo* player = index >= 0 ? &info.players[index] : 0;
+
+  switch(event.type)
+  {
+    case E_JOIN:
+    {
+      if(player) break;
+      ids.push_back(event.playerId);
+      info.players.push_back(PlayerInfo());
+      PlayerInfo& p = info.players.back();
+      p.name = event.getPlayer();
+      p.stack = event.chips;
+      p.wager = 0;
+      p.folded = false;
+      if(event.playerId == yourId)
+      {
+        info.yourIndex = info.getNumPlayers() - 1;
+        p.holeCards.assign(yourCards, yourCards + 2);
+      }
+      break;
+    }
+    case E_QUIT:
+    {
+      if(!player) break;
+      ids.erase(ids.begin() + index);
+      info.players.erase(info.players.begin() + index);
+      //the same as the Game does with the dealer
+      if(info.dealer > index) info.dealer--;
+      if(info.dealer >= info.getNumPlayers()) info.dealer = 0;
+      if(info.yourIndex == index) info.yourIndex = -1;
+      else if(info.yourIndex > index) info.yourIndex--;
+      break;
+    }
+    case E_REBUY:
+    {
+      if(player) player->stack += event.chips;
+      break;
+    }
+    case E_RECEIVE_CARDS:
+    {
+      yourId = event.playerId;
+      yourCards[0] = event.card1;
+      yourCards[1] = event.card2;
+      if(!player) break; //in the first deal, the cards come before the E_JOIN events
+      info.yourIndex = index;
+      player->holeCards.assign(yourCards, yourCards + 2);
+      break;
+    }
+    case E_NEW_DEAL:
+    {
+      info.rules.smallBlind = event.smallBlind;
+      info.rules.bigBlind = event.bigBlind;
+      info.rules.ante = event.ante;
+      info.round = R_PRE_FLOP;
+      info.turn = 0;
+      info.minRaiseAmount = event.bigBlind;
+      info.boardCards.clear();
+      for(size_t i = 0; i < info.players.size(); i++)
+      {
+        PlayerInfo& p = info.players[i];
+        p.folded = false;
+        p.showdown = false;
+        p.wager = 0;
+        if((int)i != info.yourIndex) p.holeCards.clear(); //your cards of this deal come before E_NEW_DEAL
+      }
+      break;
+    }
+    case E_DEALER:
+    {
+      if(player) info.dealer = index;
+      break;
+    }
+    case E_SMALL_BLIND:
+    case E_BIG_BLIND:
+    case E_ANTE:
+    {
+      if(!player) break;
+      placeMoney(*player, event.chips);
+      info.current = getInitialPlayer(); //the forced bets come right before the first decision
+      break;
+    }
+    case E_FOLD:
+    case E_CHECK:
+    case E_CALL:
+    case E_RAISE:
+    {
+      if(!player) break;
+      int callAmount = info.getHighestWager() - player->wager;
+      if(event.type == E_FOLD)
+      {
+        player->folded = true;
+        player->lastAction = Action(A_FOLD);
+      }
+      else if(event.type == E_CHECK) player->lastAction = Action(A_CHECK);
+      else if(event.type == E_CALL)
+      {
+        player->lastAction = Action(A_CALL);
+        placeMoney(*player, callAmount);
+      }
+      else
+      {
+        int amount = callAmount + event.chips;
+        player->lastAction = Action(A_RAISE, amount);
+        if(amount != player->stack) info.minRaiseAmount = event.chips; //an all-in raise doesn't change the minimum raise
+        placeMoney(*player, amount);
+      }
+      info.current = getNextPlayer(index);
+      break;
+    }
+    case E_FLOP:
+    case E_TURN:
+    case E_RIVER:
+    {
+      info.round = event.type == E_FLOP ? R_FLOP : (event.type == E_TURN ? R_TURN : R_RIVER);
+      info.turn = 0;
+      const Card* board[5] = { &event.card1, &event.card2, &event.card3, &event.card4, &event.card5 };
+      size_t num = event.type == E_FLOP ? 3 : (event.type == E_TURN ? 4 : 5);
+      info.boardCards.resize(num);
+      for(size_t i = 0; i < num; i++) info.boardCards[i] = *board[i];
+      info.current = getInitialPlayer();
+      break;
+    }
+    case E_SHOWDOWN:
+    {
+      info.round = R_SHOWDOWN;
+      break;
+    }
+    case E_POT_DIVISION:
+    {
+      for(size_t i = 0; i < info.players.size(); i++) info.players[i].wager = 0; //the pot goes to the winners with the E_WIN events
+      break;
+    }
+    case E_PLAYER_SHOWDOWN:
+    {
+      if(!player) break;
+      player->showdown = true;
+      player->holeCards.resize(2);
+      player->holeCards[0] = event.card1;
+      player->holeCards[1] = event.card2;
+      break;
+    }
+    case E_WIN:
+    {
+      if(player) player->stack += event.chips;
+      break;
+    }
+    default: break;
+  }
+}
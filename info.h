@@ -175,18 +175,37 @@ struct Info //all the info a player gets during a decision
 };
 
 
-//TODO: generate info from events
-//class InfoKeeper
-//{
-  //private:
-    //Info info;
-
-  //public:
-
-    //const Info& getInfo() const;
-
-    //InfoKeeper(int yourIndex); //set to -1 for global-only info
-    //~InfoKeeper();
-
-    //void onEvent(const Event& event);
-//};
+/*
+InfoKeeper makes the Info of a player from the events only, e.g. for an AI that runs in another
+process or on another computer, and gets the events but not the Info of each decision. Each event
+only updates the fields it's about, so this costs about as much as the events themselves.
+
+Forward all events the player gets to onEvent (at least those of getEventMask). The Info is about
+you once you received your hole cards (E_RECEIVE_CARDS is only sent to you), before that it's global.
+During the decisions of a player, the Info is the same as the one the Game gives to the player,
+except for the rules that the events don't tell (only the blinds and ante come from E_NEW_DEAL, the
+others are those given to the constructor), and the amount of the call actions in lastAction.
+*/
+class InfoKeeper
+{
+  private:
+    Info info;
+    std::vector<int> ids; //the player id of the events of each player in info.players
+    int yourId; //your player id, from E_RECEIVE_CARDS. -1 if not known yet
+    Card yourCards[2]; //the cards of E_RECEIVE_CARDS, the first ones come before you joined
+
+    int getIndex(const Event& event) const; //index in info.players of the player of the event, -1 if not at the table
+    int getInitialPlayer() const; //the first player to decide in this betting round, like the Game does it
+    int getNextPlayer(int index) const; //the next player after index that can still decide, -1 if none
+    void placeMoney(PlayerInfo& player, int amount); //moves chips from the stack to the wager, not more than the stack
+
+  public:
+
+    InfoKeeper(const Rules& rules = Rules());
+
+    const Info& getInfo() const;
+
+    void onEvent(const Event& event);
+
+    static EventMask getEventMask(); //the events onEvent uses, for the getEventMask of an AI that only needs an InfoKeeper
+};
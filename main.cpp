@@ -22,8 +22,8 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 
 /*
 Linux compile command:
-g++ *.cpp -W -Wall -Wextra -ansi -O3
-g++ *.cpp -W -Wall -Wextra -ansi -g3
+g++ *.cpp -W -Wall -Wextra -std=c++11 -pthread -O3
+g++ *.cpp -W -Wall -Wextra -std=c++11 -pthread -g3
 */
 
 
@@ -40,6 +40,8 @@ for his/her enjoyment.
 #include <string>
 #include <algorithm>
 #include <iostream>
+#include <sstream>
+#include <chrono>
 
 #include "ai.h"
 #include "ai_blindlimp.h"
@@ -51,14 +53,20 @@ for his/her enjoyment.
 #include "ai_smart.h"
 #include "card.h"
 #include "combination.h"
+#include "duplicate.h"
 #include "game.h"
+#include "host_headless.h"
 #include "host_terminal.h"
 #include "info.h"
 #include "io_terminal.h"
+#include "multitable.h"
 #include "observer.h"
+#include "observer_async.h"
 #include "observer_terminal.h"
 #include "observer_terminal_quiet.h"
+#include "observer_handrecord.h"
 #include "observer_log.h"
+#include "observer_statkeeper.h"
 #include "pokermath.h"
 #include "random.h"
 #include "table.h"
@@ -66,6 +74,35 @@ for his/her enjoyment.
 #include "unittest.h"
 #include "util.h"
 
+static AI* createAISmart() { return new AISmart(); }
+static AI* createAIRandom() { return new AIRandom(); }
+static AI* createAICall() { return new AICall(); }
+static AI* createAIRaise() { return new AIRaise(); }
+static AI* createAICheckFold() { return new AICheckFold(); }
+static AI* createAIBlindLimp() { return new AIBlindLimp(); }
+
+//AI battle in duplicate poker mode, see duplicate.h
+static void doDuplicate()
+{
+  HostTerminal host;
+
+  Rules rules;
+  rules.buyIn = 1000;
+  rules.smallBlind = 10;
+  rules.bigBlind = 20;
+  rules.fixedNumberOfDeals = 100;
+
+  //choose the AI players here
+  std::vector<DuplicateEntrant> entrants;
+  entrants.push_back(DuplicateEntrant(getRandomName(), createAISmart));
+  entrants.push_back(DuplicateEntrant(getRandomName(), createAIRandom));
+
+  std::vector<DuplicateResult> results;
+  runDuplicate(results, entrants, rules, 20, getRandomUint(), &host);
+
+  std::cout << std::endl << "Duplicate results:" << std::endl << duplicateResultsToString(results) << std::endl;
+}
+
 // returns whether user wants to quit
 bool doGame()
 {
@@ -79,6 +116,7 @@ bool doGame()
 2: human + AI heads-up\n\
 3: AI battle\n\
 4: AI battle heads-up\n\
+d: AI battle heads-up, duplicate\n\
 r: random game (human)\n\
 c: calculator\n\
 u: unit test\n\
@@ -90,6 +128,11 @@ q: quit" << std::endl;
   else if(c == '3') gameType = 3;
   else if(c == '4') gameType = 4;
   else if(c == 'r') gameType = 5;
+  else if(c == 'd')
+  {
+    doDuplicate();
+    return false;
+  }
   else if(c == 'c')
   {
     std::cout << "Choose Calculator\n1: Pot Equity\n2: Showdown" << std::endl;
@@ -288,8 +331,250 @@ c: custom" << std::endl;
 }
 
 
-int main()
+typedef AI* (*AICreator)();
+
+//returns null if the name isn't known
+static AICreator getAICreator(const std::string& name)
+{
+  if(name == "smart") return createAISmart;
+  if(name == "random") return createAIRandom;
+  if(name == "call") return createAICall;
+  if(name == "raise") return createAIRaise;
+  if(name == "checkfold") return createAICheckFold;
+  if(name == "blindlimp") return createAIBlindLimp;
+  return 0;
+}
+
+static void printUsage()
+{
+  std::cout << "Usage: oopoker [options]\n\
+Without options, the interactive menu is shown. With options, an AI battle is run\n\
+headless (no terminal input or output during the game), for running many deals.\n\
+--players a,b,...  the AI of each player: smart, random, call, raise, checkfold, blindlimp (default: smart,smart)\n\
+--deals n          number of deals (default: 1000). With --no-rebuy, 0 plays until one player remains\n\
+--buyin n          starting stack (default: 1000)\n\
+--sb n             small blind (default: 5)\n\
+--bb n             big blind (default: 10)\n\
+--ante n           ante (default: 0)\n\
+--no-rebuy         players who are out leave the table\n\
+--seed n           makes the game reproducible (see Game::setSeed)\n\
+--record file      records the card order of every deal\n\
+--replay file      deals the cards from a recorded file\n\
+--log file         writes all events to a log file\n\
+--log-compress     compresses the log (see observer_log.h)\n\
+--log-rotate n     continues the log in a next file (file.1, file.2, ...) after n MB\n\
+--print-log file   prints the text of a compressed or plain log file, and exits\n\
+--log-stats file   prints the player statistics calculated from a log file, and exits. Can be given\n\
+                   multiple times, e.g. for all files of a rotated log, in order\n\
+--journal file     writes all events to a binary event journal (see EventJournalWriter)\n\
+--hands file       writes a record of every deal to a binary hand record file (see handrecord.h)\n\
+--query-hands file prints the player statistics of a hand record file, and exits. Filters:\n\
+--query-seats n    only deals with n players at the table\n\
+--query-min-pot n  only deals with a pot of at least n\n\
+--stats            prints the player statistics at the end\n\
+--async            runs the log and statistics of --log and --stats on their own thread\n\
+--tables n         runs n tables at the same time on all cores (see multitable.h), each with the given players\n\
+--threads n        number of threads for --tables (default: one per core)" << std::endl;
+}
+
+//runs a game with the options from the command line. Returns the exit code of the program.
+static int doCommandLine(int argc, char* argv[])
+{
+  Rules rules;
+  rules.buyIn = 1000;
+  rules.smallBlind = 5;
+  rules.bigBlind = 10;
+  rules.ante = 0;
+  rules.allowRebuy = true;
+  rules.fixedNumberOfDeals = 1000;
+
+  std::string players = "smart,smart";
+  std::string seed, recordFile, replayFile, logFile, journalFile, handsFile, queryFile;
+  HandRecordFilter queryFilter;
+  std::vector<std::string> statLogFiles;
+  bool stats = false;
+  bool async = false;
+  LogSettings logSettings;
+  int tables = 0;
+  int threads = 0;
+
+  for(int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if(arg == "--no-rebuy") rules.allowRebuy = false;
+    else if(arg == "--stats") stats = true;
+    else if(arg == "--async") async = true;
+    else if(arg == "--log-compress") logSettings.compress = true;
+    else if(arg == "--help") { printUsage(); return 0; }
+    else if(!hasValue) { printUsage(); return 1; }
+    else if(arg == "--players") players = argv[++i];
+    else if(arg == "--deals") rules.fixedNumberOfDeals = strtoval<int>(argv[++i]);
+    else if(arg == "--buyin") rules.buyIn = strtoval<int>(argv[++i]);
+    else if(arg == "--sb") rules.smallBlind = strtoval<int>(argv[++i]);
+    else if(arg == "--bb") rules.bigBlind = strtoval<int>(argv[++i]);
+    else if(arg == "--ante") rules.ante = strtoval<int>(argv[++i]);
+    else if(arg == "--seed") seed = argv[++i];
+    else if(arg == "--record") recordFile = argv[++i];
+    else if(arg == "--replay") replayFile = argv[++i];
+    else if(arg == "--log") logFile = argv[++i];
+    else if(arg == "--log-rotate") logSettings.rotateSize = strtoval<size_t>(argv[++i]) * 1048576;
+    else if(arg == "--print-log")
+    {
+      std::string text;
+      if(!readLogFile(text, argv[++i]))
+      {
+        std::cout << "Can't read " << argv[i] << std::endl;
+        return 1;
+      }
+      std::cout << text;
+      return 0;
+    }
+    else if(arg == "--journal") journalFile = argv[++i];
+    else if(arg == "--hands") handsFile = argv[++i];
+    else if(arg == "--log-stats") statLogFiles.push_back(argv[++i]);
+    else if(arg == "--query-hands") queryFile = argv[++i];
+    else if(arg == "--query-seats") queryFilter.numSeats = strtoval<int>(argv[++i]);
+    else if(arg == "--query-min-pot") queryFilter.minPot = strtoval<int>(argv[++i]);
+    else if(arg == "--tables") tables = strtoval<int>(argv[++i]);
+    else if(arg == "--threads") threads = strtoval<int>(argv[++i]);
+    else { printUsage(); return 1; }
+  }
+
+  if(!statLogFiles.empty())
+  {
+    ObserverStatKeeper keeper;
+    long long bytes = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool ok = replayLogFiles(statLogFiles, keeper, &bytes);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << statisticsToString(keeper.getStatKeeper()) << std::endl;
+    std::cout << "bytes: " << bytes << ", seconds: " << seconds;
+    if(seconds > 0.0) std::cout << ", MB/sec: " << (bytes / seconds / 1000000.0);
+    std::cout << std::endl;
+    if(!ok)
+    {
+      std::cout << "Can't read all of the log" << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  if(!queryFile.empty())
+  {
+    HandRecordFile file;
+    if(!file.open(queryFile))
+    {
+      std::cout << "Can't read " << queryFile << std::endl;
+      return 1;
+    }
+    std::vector<HandRecordStats> result;
+    queryHandRecords(result, file, queryFilter);
+    std::cout << "Deals in file: " << file.getNumRecords() << std::endl << std::endl << handRecordStatsToString(result);
+    return 0;
+  }
+
+  //the player names are the AI name and seat number, so that the logs of reproducible games are the same too
+  std::vector<std::string> ais;
+  std::stringstream ss(players);
+  std::string name;
+  while(std::getline(ss, name, ',')) ais.push_back(name);
+
+  std::vector<DuplicateEntrant> entrants;
+  for(size_t i = 0; i < ais.size(); i++)
+  {
+    AICreator creator = getAICreator(ais[i]);
+    if(!creator)
+    {
+      std::cout << "Unknown AI: " << ais[i] << std::endl;
+      printUsage();
+      return 1;
+    }
+    AI* ai = creator();
+    entrants.push_back(DuplicateEntrant(ai->getAIName() + valtostr(i + 1), creator));
+    delete ai;
+  }
+
+  if(tables > 0)
+  {
+    if(!recordFile.empty() || !replayFile.empty() || !logFile.empty() || !journalFile.empty() || !handsFile.empty())
+    {
+      std::cout << "--record, --replay, --log, --journal and --hands can't be used with --tables" << std::endl;
+      return 1;
+    }
+
+    std::vector<MultiTableResult> results;
+    MultiTableTotals totals;
+    StatKeeper statKeeper;
+    runMultiTable(results, totals, stats ? &statKeeper : 0, entrants, rules, tables, threads
+                , seed.empty() ? getRandomUint() : strtoval<unsigned long long>(seed));
+
+    if(stats) std::cout << std::endl << statisticsToString(statKeeper) << std::endl;
+    std::cout << multiTableResultsToString(results, totals);
+
+    return 0;
+  }
+
+  HostHeadless host;
+  Game game(&host);
+  game.setRules(rules);
+
+  if(!seed.empty()) game.setSeed(strtoval<unsigned long long>(seed));
+  if(!recordFile.empty() && !game.recordDecks(recordFile))
+  {
+    std::cout << "Can't create " << recordFile << std::endl;
+    return 1;
+  }
+  if(!replayFile.empty() && !game.replayDecks(replayFile))
+  {
+    std::cout << "Can't read " << replayFile << std::endl;
+    return 1;
+  }
+  if(!journalFile.empty() && !game.journalEvents(journalFile))
+  {
+    std::cout << "Can't create " << journalFile << std::endl;
+    return 1;
+  }
+
+  for(size_t i = 0; i < entrants.size(); i++) game.addPlayer(Player(entrants[i].createAI(), entrants[i].name));
+
+  game.addObserver(host.createObserver());
+  if(!logFile.empty())
+  {
+    Observer* log = new ObserverLog(logFile, logSettings);
+    game.addObserver(async ? new ObserverAsync(log) : log);
+  }
+  if(!handsFile.empty())
+  {
+    ObserverHandRecord* hands = new ObserverHandRecord(handsFile);
+    if(!hands->isOpen())
+    {
+      std::cout << "Can't create " << handsFile << std::endl;
+      delete hands;
+      return 1;
+    }
+    game.addObserver(async ? (Observer*)new ObserverAsync(hands) : hands); //the file is complete when the game deletes its observers
+  }
+  ObserverStatKeeper* statKeeper = 0;
+  if(stats)
+  {
+    statKeeper = new ObserverStatKeeper();
+    game.addObserver(async ? (Observer*)new ObserverAsync(statKeeper) : statKeeper); //the game flushes its observers at the end, so the stats are complete after doGame
+  }
+
+  game.doGame();
+
+  if(statKeeper) std::cout << std::endl << statisticsToString(statKeeper->getStatKeeper()) << std::endl;
+  std::cout << host.getThroughputString() << std::endl;
+
+  return 0;
+}
+
+int main(int argc, char* argv[])
 {
+  if(argc > 1) return doCommandLine(argc, argv);
+
   for(;;) {
     bool quit = doGame();
     if(quit) break;
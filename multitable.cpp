@@ -0,0 +1,180 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "multitable.h"
+
+#include "game.h"
+#include "host_headless.h"
+#include "random.h"
+#include "statistics.h"
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+MultiTableResult::MultiTableResult()
+: tables(0)
+, wins(0)
+, positionSum(0)
+, score(0)
+{
+}
+
+double MultiTableResult::getAveragePosition() const
+{
+  if(tables == 0) return 0.0;
+  return (double)positionSum / tables;
+}
+
+MultiTableTotals::MultiTableTotals()
+: tables(0)
+, threads(0)
+, deals(0)
+, decisions(0)
+, seconds(0.0)
+{
+}
+
+std::string MultiTableTotals::getThroughputString() const
+{
+  std::stringstream ss;
+  ss << tables << " tables on " << threads << " threads: " << deals << " deals, " << decisions << " decisions in " << seconds << " seconds";
+  if(seconds > 0.0) ss << " (" << (deals / seconds) << " deals/s, " << (decisions / seconds) << " decisions/s)";
+  return ss.str();
+}
+
+//everything that comes out of one table
+struct TableResult
+{
+  EntrantGameResult game;
+  StatKeeper stats;
+  long long deals;
+  long long decisions;
+
+  TableResult() : deals(0), decisions(0) {}
+};
+
+static void runOneTable(TableResult& result, const std::vector<DuplicateEntrant>& entrants, const Rules& rules
+                      , int table, uint64_t seed, bool keepStats)
+{
+  //each table gets its own seed, independent of which thread runs it
+  RandomStream seeds(seed, (uint64_t)table);
+  uint64_t tableSeed = ((uint64_t)seeds.getUint() << 32) | seeds.getUint();
+
+  HostHeadless host;
+  Game game(&host);
+  game.setRules(rules);
+  game.setSeed(tableSeed);
+  game.addObserver(host.createObserver());
+  seatEntrants(game, entrants, (size_t)table, result.game, keepStats ? &result.stats : 0);
+
+  game.doGame();
+
+  result.deals = host.getNumDeals();
+  result.decisions = host.getNumDecisions();
+}
+
+void runMultiTable(std::vector<MultiTableResult>& results, MultiTableTotals& totals, StatKeeper* stats
+                 , const std::vector<DuplicateEntrant>& entrants, const Rules& rules
+                 , int numTables, int numThreads, uint64_t seed)
+{
+  size_t n = entrants.size();
+
+  results.clear();
+  results.resize(n);
+  for(size_t i = 0; i < n; i++) results[i].name = entrants[i].name;
+
+  if(numThreads <= 0) numThreads = (int)std::thread::hardware_concurrency();
+  if(numThreads <= 0) numThreads = 1;
+  if(numThreads > numTables) numThreads = numTables;
+
+  totals = MultiTableTotals();
+  totals.tables = numTables;
+  totals.threads = numThreads;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  //every table writes only to its own result, so the threads don't need any locking except for taking the next table
+  std::vector<TableResult*> tableResults(numTables);
+  for(int t = 0; t < numTables; t++) tableResults[t] = new TableResult();
+
+  std::atomic<int> nextTable(0);
+  bool keepStats = stats != 0;
+
+  std::vector<std::thread> threads;
+  for(int i = 0; i < numThreads; i++)
+  {
+    threads.push_back(std::thread([&]()
+    {
+      for(;;)
+      {
+        int t = nextTable++;
+        if(t >= numTables) break;
+        runOneTable(*tableResults[t], entrants, rules, t, seed, keepStats);
+      }
+    }));
+  }
+  for(size_t i = 0; i < threads.size(); i++) threads[i].join();
+
+  totals.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  //combine in the order of the tables, so that the result doesn't depend on the thread scheduling
+  for(int t = 0; t < numTables; t++)
+  {
+    TableResult& table = *tableResults[t];
+
+    totals.deals += table.deals;
+    totals.decisions += table.decisions;
+
+    for(size_t i = 0; i < n; i++)
+    {
+      MultiTableResult& result = results[i];
+      EntrantGameResult& game = table.game;
+      if(game.positions.find(result.name) == game.positions.end()) continue;
+      int position = game.positions[result.name];
+      result.tables++;
+      result.positionSum += position;
+      if(position == 1) result.wins++;
+      result.score += game.scores[result.name];
+      result.ai = game.ais[result.name];
+    }
+
+    if(stats) stats->add(table.stats);
+
+    delete tableResults[t];
+  }
+}
+
+std::string multiTableResultsToString(const std::vector<MultiTableResult>& results, const MultiTableTotals& totals)
+{
+  std::stringstream ss;
+  for(size_t i = 0; i < results.size(); i++)
+  {
+    const MultiTableResult& r = results[i];
+    ss << r.name << " (AI: " << r.ai << "): tables: " << r.tables << ", wins: " << r.wins
+       << ", average position: " << r.getAveragePosition() << ", score: " << r.score << std::endl;
+  }
+  ss << totals.getThroughputString() << std::endl;
+  return ss.str();
+}
@@ -0,0 +1,88 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "duplicate.h"
+#include "rules.h"
+
+class StatKeeper;
+
+/*
+Runs many independent tables of an AI battle at the same time, one per thread of a thread
+pool, to use all cores of the computer for testing AI's.
+
+Each table is its own Game, with newly created AI's, its own seed (derived from the main seed
+and the table index, so the same seed gives the same results no matter how many threads are
+used), its own headless host and its own observers. Nothing is shared between the tables while
+they run: the results are collected per table and combined at the end, in the order of the tables.
+
+The seats are rotated one further per table, so with at least as many tables as players, every
+player sat at every seat.
+*/
+
+struct MultiTableResult
+{
+  MultiTableResult();
+
+  std::string name;
+  std::string ai;
+
+  int tables; //how many tables this player played
+  int wins; //how many tables this player finished first
+  int positionSum; //sum of the finishing positions, for the average
+  long long score; //total of the tournament score (E_TOURNAMENT_RANK) of all tables
+
+  double getAveragePosition() const;
+};
+
+struct MultiTableTotals
+{
+  MultiTableTotals();
+
+  int tables;
+  int threads;
+  long long deals;
+  long long decisions;
+  double seconds; //wall clock time of the whole run
+
+  std::string getThroughputString() const;
+};
+
+/*
+Runs numTables tables of the entrants with the given rules, on numThreads threads (0 means
+one per core). The rules should end the game by themselves (fixed number of deals, or no
+rebuys), since no host can stop the tables.
+results gets one entry per entrant, in the same order. If stats isn't null, the player statistics
+of all tables are added to it.
+*/
+void runMultiTable(std::vector<MultiTableResult>& results, MultiTableTotals& totals, StatKeeper* stats
+                 , const std::vector<DuplicateEntrant>& entrants, const Rules& rules
+                 , int numTables, int numThreads, uint64_t seed);
+
+std::string multiTableResultsToString(const std::vector<MultiTableResult>& results, const MultiTableTotals& totals);
@@ -22,7 +22,7 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
-struct Event;
+#include "event.h"
 
 /*
 An observer can get events about the game, but does not participate on its own.
@@ -36,4 +36,10 @@ class Observer
     virtual ~Observer(){}
 
     virtual void onEvent(const Event& event) = 0;
+
+    //which types of events onEvent wants to get, the others aren't sent to this observer. See AI::getEventMask.
+    virtual EventMask getEventMask() const { return EVENTMASK_ALL; }
+
+    //called by the game at the end of each deal and at the end of the game. Observers that process events later (see ObserverAsync) must be done with all events when this returns.
+    virtual void flush() {}
 };
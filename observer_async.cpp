@@ -0,0 +1,131 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "observer_async.h"
+
+#include <chrono>
+
+//waits a bit for the other thread, without taking a whole core while waiting a longer time
+static void waitForOtherThread(int& spins)
+{
+  if(spins < 64) spins++;
+  else if(spins < 128) { spins++; std::this_thread::yield(); }
+  else std::this_thread::sleep_for(std::chrono::microseconds(50));
+}
+
+ObserverAsync::ObserverAsync(Observer* observer, size_t capacity)
+: observer(observer)
+, produced(0)
+, consumed(0)
+, stop(false)
+, gameStrings(0)
+{
+  size_t size = 2;
+  while(size < capacity) size *= 2;
+  ring.resize(size);
+  mask = size - 1;
+
+  thread = std::thread(&ObserverAsync::run, this);
+}
+
+ObserverAsync::~ObserverAsync()
+{
+  flush();
+  stop = true;
+  thread.join();
+  delete observer;
+}
+
+void ObserverAsync::onEvent(const Event& event)
+{
+  //when the names of the game changed (e.g. a new player joined), copy them once it's safe to do so
+  if(event.strings && (event.strings != gameStrings || event.strings->players.size() != strings.players.size()))
+  {
+    flush();
+    strings.players = event.strings->players;
+    strings.ais = event.strings->ais;
+    gameStrings = event.strings;
+  }
+
+  size_t index = produced.load(std::memory_order_relaxed);
+
+  //backpressure: wait until the background thread made room
+  int spins = 0;
+  while(index - consumed.load(std::memory_order_acquire) > mask) waitForOtherThread(spins);
+
+  Slot& slot = ring[index & mask];
+  slot.event = event;
+  if(event.messageId >= 0) slot.message = event.getMessage();
+
+  produced.store(index + 1, std::memory_order_release);
+}
+
+EventMask ObserverAsync::getEventMask() const
+{
+  return observer->getEventMask();
+}
+
+void ObserverAsync::flush()
+{
+  size_t index = produced.load(std::memory_order_relaxed);
+  int spins = 0;
+  while(consumed.load(std::memory_order_acquire) < index) waitForOtherThread(spins);
+  observer->flush();
+}
+
+Observer* ObserverAsync::getObserver()
+{
+  return observer;
+}
+
+void ObserverAsync::run()
+{
+  size_t index = 0;
+  int spins = 0;
+
+  for(;;)
+  {
+    if(produced.load(std::memory_order_acquire) == index)
+    {
+      if(stop) break; //the destructor flushed before stopping, so there's nothing left
+      waitForOtherThread(spins);
+      continue;
+    }
+    spins = 0;
+
+    Slot& slot = ring[index & mask];
+    Event event = slot.event;
+    event.strings = &strings;
+    if(event.messageId >= 0)
+    {
+      strings.messages.resize(1);
+      strings.messages[0].swap(slot.message);
+      event.messageId = 0;
+    }
+
+    observer->onEvent(event);
+
+    index++;
+    consumed.store(index, std::memory_order_release);
+  }
+}
@@ -0,0 +1,90 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "event.h"
+#include "observer.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+Runs another observer on its own thread, so that e.g. formatting a log or updating statistics
+doesn't slow down the game. The game thread only copies each event into a ring buffer, the
+background thread takes them out and gives them to the wrapped observer, in the same order.
+
+The ring buffer has room for a fixed amount of events (one reader and one writer, no locks). When
+it's full, the game waits until the background thread made room again.
+
+flush waits until the wrapped observer has processed all events. The game calls it at the end of
+each deal and at the end of the game, so the host and the code after doGame see everything
+up to date. Deleting the ObserverAsync also flushes, then stops the thread.
+
+The wrapped observer is deleted by this one. It gets events that point to their own copy of
+the player names and messages, since the game reuses its own while the background thread runs.
+*/
+class ObserverAsync : public Observer
+{
+  private:
+
+    struct Slot
+    {
+      Event event;
+      std::string message; //copy of the message of the event, if it has one
+
+      Slot() : event(E_NUM_EVENTS) {}
+    };
+
+    Observer* observer;
+
+    std::vector<Slot> ring;
+    size_t mask; //ring size - 1, the size is a power of two
+
+    //written only by the game thread
+    std::atomic<size_t> produced;
+    //written only by the background thread, after the wrapped observer processed the event
+    std::atomic<size_t> consumed;
+    std::atomic<bool> stop;
+
+    //the player names given to the wrapped observer. Only changed while the background thread has nothing to do.
+    EventStrings strings;
+    const EventStrings* gameStrings; //the strings the player names were copied from
+
+    std::thread thread;
+
+    void run(); //the background thread
+
+  public:
+
+    ObserverAsync(Observer* observer, size_t capacity = 4096);
+    virtual ~ObserverAsync();
+
+    virtual void onEvent(const Event& event);
+    virtual EventMask getEventMask() const; //same as the wrapped observer
+    virtual void flush();
+
+    Observer* getObserver(); //the wrapped observer. Only use it after flush.
+};
@@ -0,0 +1,173 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "observer_handrecord.h"
+
+#include "event.h"
+
+
+ObserverHandRecord::ObserverHandRecord(const std::string& filename)
+: writer(filename)
+, inDeal(false)
+, street(0)
+, highestBet(0)
+{
+}
+
+ObserverHandRecord::~ObserverHandRecord()
+{
+  finishDeal();
+}
+
+bool ObserverHandRecord::isOpen() const
+{
+  return writer.isOpen();
+}
+
+EventMask ObserverHandRecord::getEventMask() const
+{
+  return EVENTMASK_ALL & ~eventMask(E_LOG_MESSAGE) & ~eventMask(E_DEBUG_MESSAGE);
+}
+
+void ObserverHandRecord::addId(int id)
+{
+  if(id < (int)stacks.size()) return;
+  stacks.resize(id + 1, 0);
+  wagers.resize(id + 1, 0);
+  recordSeats.resize(id + 1, -1);
+}
+
+void ObserverHandRecord::finishDeal()
+{
+  if(!inDeal) return;
+  writer.write(record);
+  inDeal = false;
+}
+
+void ObserverHandRecord::onEvent(const Event& event)
+{
+  int id = event.playerId;
+  if(id >= 0) addId(id);
+  int seat = id >= 0 ? recordSeats[id] : -1;
+  int placed = 0; //chips moved to the pot by this event
+
+  switch(event.type)
+  {
+    case E_JOIN:
+    {
+      seats.push_back(id);
+      stacks[id] = event.chips;
+      writer.addPlayer(id, event.getPlayer(), "");
+      break;
+    }
+    case E_QUIT:
+    {
+      for(size_t i = 0; i < seats.size(); i++) if(seats[i] == id) { seats.erase(seats.begin() + i); break; }
+      break;
+    }
+    case E_REBUY: stacks[id] += event.chips; break;
+    case E_REVEAL_AI: writer.addPlayer(id, event.getPlayer(), event.getAI()); break; //the reader uses the last one
+    case E_NEW_DEAL:
+    {
+      finishDeal();
+      record = HandRecord();
+      record.numSeats = (unsigned char)(seats.size() < HR_MAX_SEATS ? seats.size() : (size_t)HR_MAX_SEATS);
+      record.bigBlind = event.bigBlind;
+      for(size_t i = 0; i < recordSeats.size(); i++) recordSeats[i] = -1;
+      for(int i = 0; i < record.numSeats; i++)
+      {
+        record.player[i] = seats[i];
+        record.stack[i] = stacks[seats[i]];
+        recordSeats[seats[i]] = i;
+        wagers[seats[i]] = 0;
+      }
+      street = 0;
+      highestBet = 0;
+      inDeal = true;
+      break;
+    }
+    case E_DEALER: if(seat >= 0) record.dealer = (unsigned char)seat; break;
+    case E_SMALL_BLIND:
+    case E_BIG_BLIND:
+    case E_ANTE:
+    {
+      placed = event.chips;
+      if(seat >= 0) record.actions[seat][street] |= HR_BLIND;
+      break;
+    }
+    case E_FOLD: if(seat >= 0) record.actions[seat][street] |= HR_FOLD; break;
+    case E_CHECK: if(seat >= 0) record.actions[seat][street] |= HR_CHECK; break;
+    case E_CALL:
+    {
+      placed = highestBet - wagers[id];
+      if(seat >= 0) record.actions[seat][street] |= HR_CALL;
+      break;
+    }
+    case E_RAISE:
+    {
+      int callAmount = highestBet - wagers[id];
+      placed = callAmount + event.chips; //the event only has the amount above the call amount
+      if(seat >= 0) record.actions[seat][street] |= (callAmount == 0 ? (int)HR_BET : (int)HR_RAISE);
+      break;
+    }
+    case E_FLOP:
+    {
+      street = 1;
+      record.board[0] = (unsigned char)event.card1.getIndex();
+      record.board[1] = (unsigned char)event.card2.getIndex();
+      record.board[2] = (unsigned char)event.card3.getIndex();
+      break;
+    }
+    case E_TURN: street = 2; record.board[3] = (unsigned char)event.card4.getIndex(); break;
+    case E_RIVER: street = 3; record.board[4] = (unsigned char)event.card5.getIndex(); break;
+    case E_POT_DIVISION: record.pot = event.chips; break;
+    case E_PLAYER_SHOWDOWN:
+    case E_BOAST:
+    {
+      if(seat < 0) break;
+      if(event.type == E_PLAYER_SHOWDOWN) record.showdown[seat] = 1;
+      record.hole[seat][0] = (unsigned char)event.card1.getIndex();
+      record.hole[seat][1] = (unsigned char)event.card2.getIndex();
+      break;
+    }
+    case E_WIN:
+    {
+      stacks[id] += event.chips;
+      if(seat >= 0) record.won[seat] += event.chips;
+      break;
+    }
+    default: break;
+  }
+
+  if(placed > 0 && id >= 0)
+  {
+    if(placed > stacks[id]) placed = stacks[id]; //when calling all-in for less than the call amount
+    stacks[id] -= placed;
+    wagers[id] += placed;
+    if(wagers[id] > highestBet) highestBet = wagers[id];
+    if(seat >= 0)
+    {
+      record.amounts[seat][street] += placed;
+      if(stacks[id] <= 0) record.actions[seat][street] |= HR_ALLIN;
+    }
+  }
+}
@@ -0,0 +1,60 @@
+/*
+OOPoker
+
+Copyright (c) 2010 Lode Vandevenne
+All rights reserved.
+
+This file is part of OOPoker.
+
+OOPoker is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OOPoker is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "handrecord.h"
+#include "observer.h"
+
+#include <vector>
+
+/*
+Observer that writes a hand record file (see handrecord.h): one record per deal, with the seats,
+stacks, actions and amounts per street, the board, the shown cards and what everyone won.
+The record of a deal is complete at the start of the next one, or when the observer is deleted.
+*/
+class ObserverHandRecord : public Observer
+{
+  private:
+
+    HandRecordWriter writer;
+    HandRecord record;
+    bool inDeal;
+
+    std::vector<int> seats; //player ids in the order of the table
+    std::vector<int> stacks; //by player id
+    std::vector<int> wagers; //by player id, chips put in the pot during this deal
+    std::vector<int> recordSeats; //by player id, seat in the record of this deal, or -1
+    int street; //0-3: pre-flop to river
+    int highestBet; //highest wager during this deal
+
+    void finishDeal();
+    void addId(int id); //makes the vectors by player id big enough
+
+  public:
+    ObserverHandRecord(const std::string& filename);
+    virtual ~ObserverHandRecord();
+    virtual void onEvent(const Event& event);
+    virtual EventMask getEventMask() const;
+
+    bool isOpen() const;
+};
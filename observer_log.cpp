@@ -1,4 +1,3 @@
-
 /*
 OOPoker
 
@@ -23,35 +22,265 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "observer_log.h"
 
+#include "compress.h"
 #include "event.h"
 #include "io_terminal.h"
+#include "util.h"
+
+#include <cstring>
+
+static const char LOG_MAGIC[] = "OOPLOGZ1";
+static const size_t LOG_MAGIC_SIZE = 8;
 
+LogSettings::LogSettings()
+: compress(false)
+, rotateSize(0)
+, blockSize(1048576)
+{
+}
 
-ObserverLog::ObserverLog(const std::string& logFileName)
+std::string getLogFileName(const std::string& logFileName, int fileNumber)
 {
-  logfile.open(logFileName.c_str(), std::ios::app);
+  if(fileNumber == 0) return logFileName;
+  return logFileName + "." + valtostr(fileNumber);
+}
 
-  //logfile << std::endl << std::endl << "======================OOPoker Log=======================" << std::endl << std::endl;
-  s += "\n\n======================OOPoker Log=======================\n\n";
+enum LogFileFormat
+{
+  LOG_FILE_MISSING,
+  LOG_FILE_EMPTY,
+  LOG_FILE_TEXT,
+  LOG_FILE_COMPRESSED
+};
 
-  s += "Date: " + getDateString() + "\n\n";
+//the format of an existing log file, from its header
+static LogFileFormat getLogFileFormat(const std::string& fileName)
+{
+  FILE* f = fopen(fileName.c_str(), "rb");
+  if(!f) return LOG_FILE_MISSING;
+  char magic[LOG_MAGIC_SIZE];
+  size_t size = fread(magic, 1, LOG_MAGIC_SIZE, f);
+  fclose(f);
+  if(size == 0) return LOG_FILE_EMPTY;
+  if(size == LOG_MAGIC_SIZE && std::memcmp(magic, LOG_MAGIC, LOG_MAGIC_SIZE) == 0) return LOG_FILE_COMPRESSED;
+  return LOG_FILE_TEXT;
+}
+
+ObserverLog::ObserverLog(const std::string& logFileName, const LogSettings& settings)
+: fileName(logFileName)
+, settings(settings)
+, file(0)
+, fileNumber(0)
+, fileSize(0)
+{
+  text.reserve(settings.blockSize + 4096); //room for the last events that go over the block size
+
+  //a rotated log of an earlier run continues in its last file, not in the first one that is already full
+  while(getLogFileFormat(getLogFileName(fileName, fileNumber + 1)) != LOG_FILE_MISSING) fileNumber++;
+  openFile();
+
+  text += "\n\n======================OOPoker Log=======================\n\n";
+
+  text += "Date: " + getDateString() + "\n\n";
 }
 
 ObserverLog::~ObserverLog()
 {
-  logfile << s;
-  s.clear();
-  logfile.close();
+  writeText(true);
+  if(file) fclose(file);
+}
+
+void ObserverLog::openFile()
+{
+  if(file) fclose(file);
+  file = 0;
+
+  for(;;)
+  {
+    std::string name = getLogFileName(fileName, fileNumber);
+    LogFileFormat format = getLogFileFormat(name);
+    if(format == LOG_FILE_MISSING || format == LOG_FILE_EMPTY || (format == LOG_FILE_COMPRESSED) == settings.compress)
+    {
+      file = fopen(name.c_str(), "ab");
+      if(!file) return;
+      setvbuf(file, 0, _IONBF, 0); //the blocks are already big, so no need to copy them into another buffer first
+
+      fseek(file, 0, SEEK_END);
+      fileSize = ftell(file);
+      if(settings.rotateSize == 0 || fileSize < settings.rotateSize) break;
+      fclose(file);
+      file = 0;
+    }
+    fileNumber++; //the file is full, or compressed while this log isn't or the other way around: the log goes to the next file
+  }
+
+  if(settings.compress && fileSize == 0)
+  {
+    fwrite(LOG_MAGIC, 1, LOG_MAGIC_SIZE, file);
+    fileSize += LOG_MAGIC_SIZE;
+  }
+}
+
+static void appendInt32(std::vector<unsigned char>& out, size_t value)
+{
+  for(int i = 0; i < 4; i++) out.push_back((unsigned char)((value >> (i * 8)) & 255));
+}
+
+void ObserverLog::writeBlock(const char* data, size_t size)
+{
+  if(!file || size == 0) return;
+
+  if(settings.compress)
+  {
+    packed.clear();
+    appendInt32(packed, size);
+    appendInt32(packed, 0); //the compressed size, filled in below
+    size_t packedSize = compressBlock(packed, (const unsigned char*)data, size);
+    for(int i = 0; i < 4; i++) packed[4 + i] = (unsigned char)((packedSize >> (i * 8)) & 255);
+    fileSize += fwrite(&packed[0], 1, packed.size(), file);
+  }
+  else fileSize += fwrite(data, 1, size, file);
+
+  if(settings.rotateSize > 0 && fileSize >= settings.rotateSize)
+  {
+    fileNumber++;
+    openFile();
+  }
+}
+
+void ObserverLog::writeText(bool all)
+{
+  size_t pos = 0;
+  while(text.size() - pos >= settings.blockSize)
+  {
+    writeBlock(text.data() + pos, settings.blockSize);
+    pos += settings.blockSize;
+  }
+  if(all)
+  {
+    writeBlock(text.data() + pos, text.size() - pos);
+    pos = text.size();
+  }
+  text.erase(0, pos); //moves the few remaining bytes to the front, the memory stays allocated
 }
 
 void ObserverLog::onEvent(const Event& event)
 {
-  //logfile << eventToString(event) << std::endl;
-  s += eventToString(event) + "\n";
+  appendEventString(text, event);
+  text += '\n';
+
+  if(text.size() >= settings.blockSize) writeText(false);
+}
+
+static size_t readInt32(const unsigned char* p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((size_t)p[3] << 24);
+}
+
+/*
+Reads the text of a log file, compressed or not, in blocks, and calls f(text, size) for each
+block. Only one block is in memory at a time. A block can end in the middle of a line.
+*/
+template<typename F>
+static bool forEachLogBlock(const std::string& fileName, F& f)
+{
+  FILE* file = fopen(fileName.c_str(), "rb");
+  if(!file) return false;
+
+  bool ok = true;
+  std::vector<char> text(1048576);
+  size_t n = fread(&text[0], 1, LOG_MAGIC_SIZE, file);
+  if(n < LOG_MAGIC_SIZE || std::memcmp(&text[0], LOG_MAGIC, LOG_MAGIC_SIZE) != 0)
+  {
+    //a plain text log, of which the first bytes are already read
+    do f(&text[0], n); while((n = fread(&text[0], 1, text.size(), file)) > 0);
+  }
+  else
+  {
+    std::vector<unsigned char> packed;
+    unsigned char header[8];
+    while((n = fread(header, 1, 8, file)) > 0)
+    {
+      size_t size = n == 8 ? readInt32(header) : 0;
+      size_t packedSize = n == 8 ? readInt32(header + 4) : 0;
+      if(size == 0 || packedSize == 0 || size > 1073741824 || packedSize > compressBound(size)) { ok = false; break; }
+      packed.resize(packedSize);
+      text.resize(size);
+      if(fread(&packed[0], 1, packedSize, file) != packedSize || !decompressBlock((unsigned char*)&text[0], size, &packed[0], packedSize))
+      {
+        ok = false;
+        break;
+      }
+      f(&text[0], size);
+    }
+  }
+
+  fclose(file);
+  return ok;
+}
+
+struct LogTextAppender
+{
+  std::string& text;
+
+  LogTextAppender(std::string& text) : text(text) {}
+  void operator()(const char* data, size_t size) { text.append(data, size); }
+};
+
+bool readLogFile(std::string& text, const std::string& fileName)
+{
+  LogTextAppender appender(text);
+  return forEachLogBlock(fileName, appender);
+}
+
+//parses the lines of the blocks of text and gives the events to the observer
+struct LogReplayer
+{
+  EventParser parser;
+  Observer& observer;
+  EventMask mask;
+  Event event;
+  std::string carry; //the start of a line of which the rest is in the next block
+  long long bytes;
 
-  if(s.size() > 1000000) //not sure if this has a point or not, but I don't want it to access disk non-stop all the time, only write every million characters.
+  LogReplayer(Observer& observer) : observer(observer), mask(observer.getEventMask()), event(E_NUM_EVENTS), bytes(0) {}
+
+  void line(const char* begin, const char* end)
   {
-    logfile << s;
-    s.clear();
+    if(parser.parse(event, begin, end) && (mask & eventMask(event.type))) observer.onEvent(event);
   }
+
+  void operator()(const char* text, size_t size)
+  {
+    bytes += size;
+    const char* end = text + size;
+    const char* p = text;
+    while(p != end)
+    {
+      const char* newline = (const char*)std::memchr(p, '\n', end - p);
+      if(!newline)
+      {
+        carry.append(p, end);
+        break;
+      }
+      if(carry.empty()) line(p, newline);
+      else
+      {
+        carry.append(p, newline);
+        line(carry.data(), carry.data() + carry.size());
+        carry.clear();
+      }
+      p = newline + 1;
+    }
+  }
+};
+
+bool replayLogFiles(const std::vector<std::string>& fileNames, Observer& observer, long long* numBytes)
+{
+  LogReplayer replayer(observer);
+  bool ok = true;
+  for(size_t i = 0; i < fileNames.size() && ok; i++) ok = forEachLogBlock(fileNames[i], replayer);
+  if(!replayer.carry.empty()) replayer.line(replayer.carry.data(), replayer.carry.data() + replayer.carry.size()); //no newline at the end
+  if(numBytes) *numBytes = replayer.bytes;
+  return ok;
 }
@@ -24,22 +24,70 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "observer.h"
 
-#include <iostream>
-#include <fstream>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct LogSettings
+{
+  LogSettings();
+
+  bool compress; //compress the log with the block codec of compress.h. Use readLogFile to get the text back.
+  size_t rotateSize; //when a file becomes bigger than this, the log continues in the next file: "log.txt", "log.txt.1", "log.txt.2", ... 0 means never.
+  size_t blockSize; //how many bytes of text are gathered before writing (and compressing) them
+};
 
 /*
 Observer that writes all events to a log file on disk.
+
+The text of the events is formatted into one preallocated buffer, and written to the file in whole
+blocks only (one fwrite per block, without further buffering), so for long AI battles the log
+costs almost nothing. Like before, the log is appended to the file if it already exists, but
+only if that file has the same format (compressed or not). Otherwise the log goes to the next file
+name, like with rotation (see getLogFileName). A rotated log continues after the last file that
+exists, so that the runs don't get mixed in the files.
+
+A compressed log file starts with "OOPLOGZ1", followed by blocks that are each: the size of the
+text, the compressed size (both 32-bit little endian) and then the compressed data.
 */
 class ObserverLog : public Observer
 {
   private:
 
-    std::ofstream logfile;
-    std::string s;
+    std::string fileName;
+    LogSettings settings;
+
+    FILE* file;
+    int fileNumber; //for the rotation
+    size_t fileSize; //how many bytes the current file has
+
+    std::string text; //the text not yet written
+    std::vector<unsigned char> packed; //the compressed block
 
+    void openFile();
+    void writeBlock(const char* data, size_t size);
+    void writeText(bool all); //writes the full blocks of text, or everything if all is true
 
   public:
-    ObserverLog(const std::string& logFileName);
+    ObserverLog(const std::string& logFileName, const LogSettings& settings = LogSettings());
     virtual ~ObserverLog();
     virtual void onEvent(const Event& event);
 };
+
+std::string getLogFileName(const std::string& logFileName, int fileNumber); //the name of the file of a rotated log, fileNumber 0 is the first
+
+/*
+Reads a log written by ObserverLog, compressed or not, and appends its text to the given string.
+Only reads the one given file, for rotated logs use getLogFileName to get all of them. Returns
+false if the file can't be read or is corrupt.
+*/
+bool readLogFile(std::string& text, const std::string& fileName);
+
+/*
+Parses the logs (compressed or not) back into events with EventParser, and gives them to the
+observer, e.g. an ObserverStatKeeper to calculate the statistics of old games. The files are read
+one block at a time, so they can be much bigger than the memory. Give the files of a rotated log
+in order: a line can continue in the next file. numBytes, if not null, gets the amount of text
+read. Returns false if a file can't be read or is corrupt.
+*/
+bool replayLogFiles(const std::vector<std::string>& fileNames, Observer& observer, long long* numBytes = 0);
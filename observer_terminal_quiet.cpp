@@ -28,24 +28,15 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 
 void ObserverTerminalQuiet::onEvent(const Event& event)
 {
-  bool show_event = false;
-
-  if(event.type == E_NEW_DEAL) show_event = true;
-  if(event.type == E_JOIN) show_event = true;
-  if(event.type == E_QUIT) show_event = true;
-  if(event.type == E_LOG_MESSAGE) show_event = true;
-  if(event.type == E_DEBUG_MESSAGE) show_event = true;
-  if(event.type == E_PLAYER_SHOWDOWN) show_event = true;
-  if(event.type == E_BOAST) show_event = true;
-  if(event.type == E_FLOP) show_event = true;
-  if(event.type == E_TURN) show_event = true;
-  if(event.type == E_RIVER) show_event = true;
-  if(event.type == E_WIN) show_event = true;
-  if(event.type == E_TOURNAMENT_RANK) show_event = true;
-  if(event.type == E_REVEAL_AI) show_event = true;
-
-
-  if(show_event) std::cout << "> " << eventToStringVerbose(event) << std::endl;
+  //only the events from getEventMask come here
+  std::cout << "> " << eventToStringVerbose(event) << std::endl;
 
   //sleepMS(options.sleepMS);
 }
+
+EventMask ObserverTerminalQuiet::getEventMask() const
+{
+  return eventMask(E_NEW_DEAL) | eventMask(E_JOIN) | eventMask(E_QUIT) | eventMask(E_LOG_MESSAGE) | eventMask(E_DEBUG_MESSAGE)
+       | eventMask(E_PLAYER_SHOWDOWN) | eventMask(E_BOAST) | eventMask(E_FLOP) | eventMask(E_TURN) | eventMask(E_RIVER)
+       | eventMask(E_WIN) | eventMask(E_TOURNAMENT_RANK) | eventMask(E_REVEAL_AI);
+}
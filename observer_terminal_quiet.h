@@ -31,4 +31,5 @@ class ObserverTerminalQuiet : public Observer
 {
   public:
     virtual void onEvent(const Event& event);
+    virtual EventMask getEventMask() const;
 };
@@ -36,6 +36,8 @@ Player::Player(AI* ai, const std::string& name)
 , folded(false)
 , showdown(false)
 , name(name)
+, id(-1)
+, random(0)
 {
 }
 
@@ -45,7 +47,7 @@ void Player::setCards(Card card1, Card card2)
   holeCard2 = card2;
 }
 
-std::string Player::getName() const
+const std::string& Player::getName() const
 {
   return name;
 }
@@ -57,9 +59,22 @@ std::string Player::getAIName() const
 
 Action Player::doTurn(const Info& info)
 {
+  RandomStreamScope scope(random);
   return ai->doTurn(info);
 }
 
+bool Player::boastCards(const Info& info)
+{
+  RandomStreamScope scope(random);
+  return ai->boastCards(info);
+}
+
+bool Player::wantsToLeave(const Info& info)
+{
+  RandomStreamScope scope(random);
+  return ai->wantsToLeave(info);
+}
+
 bool Player::isAllIn() const
 {
   return stack <= 0 && wager > 0;
@@ -87,9 +102,15 @@ bool Player::isHuman() const
 
 void Player::onEvent(const Event& event)
 {
+  RandomStreamScope scope(random);
   ai->onEvent(event);
 }
 
+EventMask Player::getEventMask() const
+{
+  return ai->getEventMask();
+}
+
 
 
 static const int SC = 17;
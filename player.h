@@ -29,6 +29,7 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 
 class AI;
 struct Info;
+class RandomStream;
 
 /*
 A Player is what joins the table and plays the game. Each player must have an AI,
@@ -55,9 +56,12 @@ struct Player
   bool showdown; //this player (has to or wants to) show their cards
 
   std::string name;
+  int id; //player id used in the events (see Event::getPlayer), set by Game::addPlayer
 
   Action lastAction; //used for filling it in the Info
 
+  RandomStream* random; //if not null, the AI draws its random numbers from this stream (for reproducible games). Not owned by the player.
+
   Player(AI* ai, const std::string& name);
 
   void setCards(Card card1, Card card2);
@@ -69,11 +73,14 @@ struct Player
   -spaces and dots are allowed
   -semicolons and commas are not allowed. This because semicolons are often used in logs and such, allowing parsers to know they're not part of a name.
   */
-  std::string getName() const; //min 1 letter,
+  const std::string& getName() const; //min 1 letter,
   std::string getAIName() const;
 
   Action doTurn(const Info& info);
   void onEvent(const Event& event);
+  EventMask getEventMask() const;
+  bool boastCards(const Info& info);
+  bool wantsToLeave(const Info& info);
 
   bool isAllIn() const;
   bool isOut() const; //can't play anymore, has no more money
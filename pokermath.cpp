@@ -23,10 +23,17 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #include "pokermath.h"
 
 #include "combination.h"
+#include "deck.h"
+#include "enumerate.h"
 #include "pokereval.h"
 #include "pokereval2.h"
 #include "random.h"
 
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <map>
+
 
 double factorial(int i)
 {
@@ -54,7 +61,7 @@ Notation ascii art representation:
   double result = 1;
   for(int i = 1; i <= p; i++)
   {
-    result *= (n - p + i) / i;
+    result *= (double)(n - p + i) / i;
   }
 
   return result;
@@ -250,80 +257,101 @@ void getHighestNearFlush(std::vector<Card>& result, const std::vector<Card>& car
 ////////////////////////////////////////////////////////////////////////////////
 
 
-void getWinChanceAgainst1AtFlop(double& win, double& tie, double& lose
-                              , const Card& hand1, const Card& hand2
-                              , const Card& table1, const Card& table2, const Card& table3)
+/*
+Counts wins, ties and losses of your hand against the hand of one opponent. The array c
+has your 2 hole cards in c[0] and c[1], the 5 board cards in c[2] to c[6], and the opponent
+hand in c[7] and c[8]. This is called by the enumeration for every possible opponent hand.
+*/
+struct Against1Counter
 {
-  win = tie = lose = 0.0;
-
-  //an array of 9 values, set up to contain your hand, the 5 table cards, and then the randomly generated players hand
-  int c[9];
-
-  c[0] = eval7_index(hand1);
-  c[1] = eval7_index(hand2);
-  c[2] = eval7_index(table1);
-  c[3] = eval7_index(table2);
-  c[4] = eval7_index(table3);
+  int* c;
+  int yourVal; //must be updated whenever the board cards change
+  int wins;
+  int ties;
+  int losses;
+
+  Against1Counter(int* c)
+  : c(c)
+  , yourVal(0)
+  , wins(0)
+  , ties(0)
+  , losses(0)
+  {
+  }
 
-  static const int NUMOTHER = 47;
+  void operator()(const int* /*opponent hand, already in c[7] and c[8]*/)
+  {
+    int otherVal = eval7(&c[2]);
 
-  int others[NUMOTHER];
+    if(otherVal == yourVal) ties++;
+    else if(otherVal < yourVal) wins++;
+    else losses++;
+  }
+};
 
-  int j = 0;
-  for(int i = 0; i < 52; i++)
+//called by the enumeration for every possible completion of the board, enumerates all opponent hands for that board
+struct Against1BoardCounter
+{
+  Against1Counter& counter;
+  CardMask remaining; //cards not in your hand or on the known board
+  int numUnknown; //amount of unknown board cards
+
+  Against1BoardCounter(Against1Counter& counter, CardMask remaining, int numUnknown)
+  : counter(counter)
+  , remaining(remaining)
+  , numUnknown(numUnknown)
   {
-    int v = eval7_index(Card(i));
-    if(v == c[0] || v == c[1]) continue;
-    if(v == c[2] || v == c[3] || v == c[4]) continue;
-    if(j >= NUMOTHER) break;
+  }
 
-    others[j] = v;
-    j++;
+  void operator()(const int* unknownBoardCards)
+  {
+    counter.yourVal = eval7(&counter.c[0]);
+    CardMask rest = remaining & ~cardsToMask(unknownBoardCards, numUnknown);
+    enumerateKSubsets(2, rest, &counter.c[7], counter);
   }
+};
 
-  int wins = 0;
-  int ties = 0;
-  int losses = 0;
+/*
+Exhaustive search over all unknown board cards and all possible hands of the opponent.
+c: array of 9 values, with your hand in c[0], c[1] and the numBoard known board cards from c[2] on.
+*/
+static void getWinChanceAgainst1(double& win, double& tie, double& lose, int* c, int numBoard)
+{
+  CardMask remaining = CARDMASK_ALL & ~cardsToMask(c, 2 + numBoard);
+  int numUnknown = 5 - numBoard;
 
-  int count = 0;
+  Against1Counter counter(c);
+  Against1BoardCounter boardCounter(counter, remaining, numUnknown);
+  enumerateKSubsets(numUnknown, remaining, &c[2 + numBoard], boardCounter);
 
-  //all possible 2-hand combinations of the other player + cards on the table
-  for(int i = 0; i < NUMOTHER - 1; i++) //table
-  for(int j = i + 1; j < NUMOTHER; j++) //table
-  for(int k = 0; k < NUMOTHER - 1; k++) //opponent hand
-  {
-    if(k == i || k == j) continue;
-    for(int l = k + 1; l < NUMOTHER; l++) //opponent hand
-    {
-      if(l == i || l == j) continue;
-      c[5] = others[i];
-      c[6] = others[j];
-      c[7] = others[k];
-      c[8] = others[l];
+  int count = counter.wins + counter.ties + counter.losses;
 
-      int yourVal = eval7(&c[0]);
-      int otherVal = eval7(&c[2]);
+  win = (double)counter.wins / count;
+  tie = (double)counter.ties / count;
+  lose = (double)counter.losses / count;
+}
 
-      if(otherVal == yourVal) ties++;
-      else if(otherVal < yourVal) wins++;
-      else losses++;
+void getWinChanceAgainst1AtFlop(double& win, double& tie, double& lose
+                              , const Card& hand1, const Card& hand2
+                              , const Card& table1, const Card& table2, const Card& table3)
+{
+  //an array of 9 values, set up to contain your hand, the 5 table cards, and then the opponents hand
+  int c[9];
 
-      count++;
-    }
-  }
+  c[0] = eval7_index(hand1);
+  c[1] = eval7_index(hand2);
+  c[2] = eval7_index(table1);
+  c[3] = eval7_index(table2);
+  c[4] = eval7_index(table3);
 
-  win = (double)wins / count;
-  tie = (double)ties / count;
-  lose = (double)losses / count;
+  getWinChanceAgainst1(win, tie, lose, c, 3);
 }
 
 void getWinChanceAgainst1AtTurn(double& win, double& tie, double& lose
                               , const Card& hand1, const Card& hand2
                               , const Card& table1, const Card& table2, const Card& table3, const Card& table4)
 {
-  win = tie = lose = 0.0;
-
-  //an array of 9 values, set up to contain your hand, the 5 table cards, and then the randomly generated players hand
+  //an array of 9 values, set up to contain your hand, the 5 table cards, and then the opponents hand
   int c[9];
 
   c[0] = eval7_index(hand1);
@@ -333,66 +361,14 @@ void getWinChanceAgainst1AtTurn(double& win, double& tie, double& lose
   c[4] = eval7_index(table3);
   c[5] = eval7_index(table4);
 
-  static const int NUMOTHER = 46;
-
-  int others[NUMOTHER];
-
-  int j = 0;
-  for(int i = 0; i < 52; i++)
-  {
-    int v = eval7_index(Card(i));
-    if(v == c[0] || v == c[1]) continue;
-    if(v == c[2] || v == c[3] || v == c[4] || v == c[5]) continue;
-    if(j >= NUMOTHER) break;
-
-    others[j] = v;
-    j++;
-  }
-
-
-
-  int wins = 0;
-  int ties = 0;
-  int losses = 0;
-
-  int count = 0;
-
-  //all possible 2-hand combinations of the other player + cards on the table
-  for(int i = 0; i < NUMOTHER; i++) //table
-  for(int j = 0; j < NUMOTHER - 1; j++) //opponent hand
-  {
-    if(j == i) continue;
-    for(int k = j + 1; k < NUMOTHER; k++) //opponent hand
-    {
-      if(k == i) continue;
-
-      c[6] = others[i];
-      c[7] = others[j];
-      c[8] = others[k];
-
-      int yourVal = eval7(&c[0]);
-      int otherVal = eval7(&c[2]);
-
-      if(otherVal == yourVal) ties++;
-      else if(otherVal < yourVal) wins++;
-      else losses++;
-
-      count++;
-    }
-  }
-
-  win = (double)wins / count;
-  tie = (double)ties / count;
-  lose = (double)losses / count;
+  getWinChanceAgainst1(win, tie, lose, c, 4);
 }
 
 void getWinChanceAgainst1AtRiver(double& win, double& tie, double& lose
                                , const Card& hand1, const Card& hand2
                                , const Card& table1, const Card& table2, const Card& table3, const Card& table4, const Card& table5)
 {
-  win = tie = lose = 0.0;
-
-  //an array of 9 values, set up to contain your hand, the 5 table cards, and then the randomly generated players hand
+  //an array of 9 values, set up to contain your hand, the 5 table cards, and then the opponents hand
   int c[9];
 
   c[0] = eval7_index(hand1);
@@ -403,49 +379,7 @@ void getWinChanceAgainst1AtRiver(double& win, double& tie, double& lose
   c[5] = eval7_index(table4);
   c[6] = eval7_index(table5);
 
-  static const int NUMOTHER = 45;
-
-  int others[NUMOTHER];
-
-  int j = 0;
-  for(int i = 0; i < 52; i++)
-  {
-    int v = eval7_index(Card(i));
-    if(v == c[0] || v == c[1]) continue;
-    if(v == c[2] || v == c[3] || v == c[4] || v == c[5] || v == c[6]) continue;
-    if(j >= NUMOTHER) break;
-
-    others[j] = v;
-    j++;
-  }
-
-  int yourVal = eval7(&c[0]);
-
-  int wins = 0;
-  int ties = 0;
-  int losses = 0;
-
-  int count = 0;
-
-  //all possible 2-hand combinations of the other player
-  for(int i = 0; i < NUMOTHER; i++)
-  for(int j = i + 1; j < NUMOTHER; j++)
-  {
-    c[7] = others[i];
-    c[8] = others[j];
-
-    int otherVal = eval7(&c[2]);
-
-    if(otherVal == yourVal) ties++;
-    else if(otherVal < yourVal) wins++;
-    else losses++;
-
-    count++;
-  }
-
-  win = (double)wins / count;
-  tie = (double)ties / count;
-  lose = (double)losses / count;
+  getWinChanceAgainst1(win, tie, lose, c, 5);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -458,155 +392,315 @@ void getWinChanceAgainst1AtRiver(double& win, double& tie, double& lose
 ////////////////////////////////////////////////////////////////////////////////
 
 /*
-This function is there for efficiently choosing "amount" unique random cards
-out of a list of "size" cards. For that, this function shuffles the first "amount"
-cards of the list.
-The intention is that this function is:
--Fast (it's for monte carlo simulations of many hands)
--Properly Random (no errors that skew the randomness)
-So the function is made O(amount), instead of shuffling
-the whole deck all the time which would result in an O(size) function.
-When the function is done, use the first "amount" cards from "values" to
-have your really new randomly shuffled cards.
+Fills in the unknown board cards and the opponent hands from drawn, evaluates
+all hands, and returns 2 if you win, 1 if you tie, 0 if you lose.
+c has your hand in c[0] and c[1], then the numBoard known board cards. drawn has
+the 5 - numBoard unknown board cards first, followed by 2 cards per opponent.
 */
-static void shuffleN(int* values, int size, int amount)
+static int getStatusAgainstN(int* c, int numBoard, const int* drawn, int numOpponents)
 {
-  for(int i = 0; i < amount; i++)
+  int numUnknown = 5 - numBoard;
+  for(int i = 0; i < numUnknown; i++) c[2 + numBoard + i] = drawn[i];
+
+  int yourVal = eval7(&c[0]);
+
+  int status = 2; //2: you win, 1: you tie, 0: you lose
+
+  for(int j = 0; j < numOpponents; j++)
   {
-    int r = getRandomFast(0, size - 1);
-    std::swap(values[i], values[r]);
+    //opponents hand
+    c[7] = drawn[numUnknown + j * 2];
+    c[8] = drawn[numUnknown + 1 + j * 2];
+
+    int opponentVal = eval7(&c[2]);
+
+    if(opponentVal == yourVal) status = 1; //tie
+    else if(opponentVal > yourVal) { status = 0; break; } //lose, stop rest of loop.
   }
+
+  return status;
 }
 
-void getWinChanceAgainstNAtPreFlop(double& win, double& tie, double& lose
-                                 , const Card& hand1, const Card& hand2
-                                 , int numOpponents, int numSamples)
+//Collects the subsets visited by enumerateKSubsets in one flat array, k values per subset.
+struct SubsetCollector
 {
-  win = tie = lose = 0.0;
+  std::vector<int>& result;
+  int k;
 
-  //an array of 9 values, set up to contain your hand, the 5 table cards, and then the randomly generated players hand
-  int c[9];
+  SubsetCollector(std::vector<int>& result, int k)
+  : result(result)
+  , k(k)
+  {
+  }
 
-  c[0] = eval7_index(hand1);
-  c[1] = eval7_index(hand2);
+  void operator()(const int* out)
+  {
+    for(int i = 0; i < k; i++) result.push_back(out[i]);
+  }
+};
 
-  static const int NUMOTHER = 50;
+/*
+Stratified sampling of the runouts, see SM_STRATIFIED in pokermath.h.
 
-  int others[NUMOTHER];
+The first (up to 2) unknown board cards are the strata: all possible combinations of
+them are listed, and the samples are spread evenly over those with systematic sampling
+(one random offset, then fixed steps). So at the flop every possible turn and river is
+visited about equally often, instead of only on average.
 
-  int j = 0;
-  for(int i = 0; i < 52; i++)
-  {
-    int v = eval7_index(Card(i));
-    if(v == c[0] || v == c[1]) continue;
-    if(j >= NUMOTHER) break;
+The two cards after the strata (the third and fourth unknown board card pre-flop, or else
+the hand of the first opponent) are chosen as a pair, with a golden ratio additive recurrence
+(a low discrepancy sequence) over the numbers of all possible pairs. Together with the strata
+that forms a lattice that covers both evenly. All further cards are random.
+*/
+static void sampleStratified(int& wins, int& ties, int& losses
+                           , int* c, int numBoard, const int* others, int numOther
+                           , int numOpponents, int numSamples)
+{
+  int numUnknown = 5 - numBoard;
+  int numDrawn = numUnknown + numOpponents * 2;
+  int s = numUnknown < 2 ? numUnknown : 2; //amount of cards in a stratum
 
-    others[j] = v;
-    j++;
-  }
+  std::vector<int> strata;
+  int out[2];
+  SubsetCollector collector(strata, s);
+  enumerateKSubsets(s, others, numOther, out, collector);
+  int numStrata = s == 0 ? 1 : (int)strata.size() / s;
 
-  int wins = 0;
-  int ties = 0;
-  int losses = 0;
+  static const double GOLDEN = 0.6180339887498949; //fractional part of the golden ratio
+  double offset = getRandomFast(); //random offset of the systematic sampling of the strata
+  double start = getRandomFast(); //random start of the low discrepancy sequence
+
+  int drawn[52]; //first the cards of the stratum, then the cards of rest, in the order chosen for the current sample
+  int sorted[52]; //the cards that are not in the current stratum, in a fixed order
+  int rest[52]; //the same cards, in the order in which they were last shuffled
+  int pos[52]; //index in rest of each card
+  int numRest = numOther - s;
+  int numRandom = numDrawn - s - 2; //amount of cards drawn at random from rest
+  int numPairs = numRest * (numRest - 1) / 2;
+
+  int stratum = -1;
 
   for(int i = 0; i < numSamples; i++)
   {
-    shuffleN(others, NUMOTHER, 2 + numOpponents * 2); //the two extra table cards, and the cards of all opponents
+    int st = (int)((i + offset) * numStrata / numSamples);
+    if(st >= numStrata) st = numStrata - 1;
 
-    c[2] = others[0];
-    c[3] = others[1];
-    c[4] = others[2];
-    c[5] = others[3];
-    c[6] = others[4];
-
-    int yourVal = eval7(&c[0]);
+    if(st != stratum)
+    {
+      stratum = st;
 
-    int status = 2; //2: you win, 1: you tie, 0: you lose
+      for(int j = 0; j < s; j++) drawn[j] = strata[stratum * s + j];
+      int n = 0;
+      for(int j = 0; j < numOther; j++)
+      {
+        int v = others[j];
+        if((s > 0 && v == drawn[0]) || (s > 1 && v == drawn[1])) continue;
+        sorted[n] = rest[n] = v;
+        pos[v] = n;
+        n++;
+      }
+    }
 
-    for(int j = 0; j < numOpponents; j++)
+    //the two low discrepancy cards go in front of rest
+    double x = start + i * GOLDEN;
+    int pair = (int)((x - (int)x) * numPairs);
+    int index2 = (int)((1.0 + std::sqrt(1.0 + 8.0 * pair)) / 2.0); //pair number to the two indices, in colex order
+    while(index2 * (index2 - 1) / 2 > pair) index2--;
+    while((index2 + 1) * index2 / 2 <= pair) index2++;
+    int index1 = pair - index2 * (index2 - 1) / 2;
+    for(int j = 0; j < 2; j++)
     {
-      //opponents hand
-      c[7] = others[5 + j * 2];
-      c[8] = others[6 + j * 2];
-
-      int opponentVal = eval7(&c[2]);
+      int p = pos[sorted[j == 0 ? index1 : index2]];
+      std::swap(rest[j], rest[p]);
+      pos[rest[p]] = p;
+      pos[rest[j]] = j;
+    }
 
-      if(opponentVal == yourVal) status = 1; //tie
-      else if(opponentVal > yourVal) { status = 0; break; } //lose, stop rest of loop.
+    //partial Fisher-Yates shuffle of the rest
+    for(int j = 2; j < 2 + numRandom; j++)
+    {
+      int r = getRandomFast(j, numRest - 1);
+      std::swap(rest[j], rest[r]);
+      pos[rest[j]] = j;
+      pos[rest[r]] = r;
     }
 
+    for(int j = 0; j < 2 + numRandom; j++) drawn[s + j] = rest[j];
+
+    int status = getStatusAgainstN(c, numBoard, drawn, numOpponents);
     if(status == 0) losses++;
     else if(status == 1) ties++;
     else wins++;
   }
+}
 
-  win = (double)wins / numSamples;
-  tie = (double)ties / numSamples;
-  lose = (double)losses / numSamples;
+/*
+The batched Monte Carlo sampler (SM_BATCHED) works in three stages on BATCH samples at a
+time, instead of one sample at a time:
+1) deal the boards of all samples, each sample has its own deck. The boards and hands are
+   stored as masks, each in their own array (structure of arrays).
+2) rank whole arrays at once: these are long loops of independent evaluations, so the
+   processor can overlap the table lookups of many of them. The opponents are done one by
+   one, each as an array of hands dealt from the decks of the samples. Samples that are
+   already lost are dropped from the array of the next opponent without branching, so
+   with many opponents most hands never need to be dealt or ranked.
+3) count wins, ties and losses with comparisons instead of branches
+*/
+static const int BATCH = 256;
+
+static void initPokerEval2()
+{
+  static bool inited = (PokerEval2::InitializeHandRankingTables(), true); //initialized only once, also if multiple threads get here at the same time
+  (void)inited;
 }
 
-void getWinChanceAgainstNAtFlop(double& win, double& tie, double& lose
-                               , const Card& hand1, const Card& hand2
-                               , const Card& table1, const Card& table2, const Card& table3
-                               , int numOpponents, int numSamples)
+//ranks[i] = rank of the 7 cards hands[i] combined with board[i]
+static void rankColumn(PokerEval2::HandVal* ranks, const PokerEval2::HandMask* hands, const PokerEval2::HandMask* board, int num)
 {
-  win = tie = lose = 0.0;
+  for(int i = 0; i < num; i++) ranks[i] = PokerEval2::RankHand(hands[i] | board[i]);
+}
 
-  //an array of 9 values, set up to contain your hand, the 5 table cards, and then the randomly generated players hand
-  int c[9];
+/*
+Ranks the hands of one opponent, only for the samples in alive (the ones where you didn't
+lose yet), and removes the samples where this opponent beats you from alive. Returns the
+new amount of alive samples. Sets tied[i] to 1 if the opponent ties with you.
+*/
+static int rankColumnAlive(int* alive, int numAlive, unsigned char* tied, const PokerEval2::HandVal* yourVal
+                         , const PokerEval2::HandMask* hands, const PokerEval2::HandMask* board)
+{
+  int result = 0;
+  for(int k = 0; k < numAlive; k++)
+  {
+    int i = alive[k];
+    PokerEval2::HandVal rank = PokerEval2::RankHand(hands[i] | board[i]);
+    tied[i] |= (rank == yourVal[i]);
+    alive[result] = i;
+    result += (rank <= yourVal[i]);
+  }
+  return result;
+}
 
-  c[0] = eval7_index(hand1);
-  c[1] = eval7_index(hand2);
-  c[2] = eval7_index(table1);
-  c[3] = eval7_index(table2);
-  c[4] = eval7_index(table3);
+static void sampleBatched(int& wins, int& ties, int& losses
+                        , const int* c, int numBoard, const int* others, int numOther
+                        , int numOpponents, int numSamples)
+{
+  using PokerEval2::HandMask;
+  using PokerEval2::HandVal;
+  using PokerEval2::HandMasksTable;
+
+  initPokerEval2();
 
-  static const int NUMOTHER = 47;
+  int numUnknown = 5 - numBoard;
 
-  int others[NUMOTHER];
+  HandMask knownBoard = 0;
+  for(int i = 0; i < numBoard; i++) knownBoard |= HandMasksTable[c[2 + i]];
+  HandMask hand = HandMasksTable[c[0]] | HandMasksTable[c[1]];
+
+  unsigned char decks[BATCH * 52]; //the remaining cards of each sample, the first ones already dealt
+  HandMask board[BATCH];
+  HandMask yourHand[BATCH];
+  HandMask opponent[BATCH]; //hand of the current opponent
+  HandVal yourVal[BATCH];
+  int alive[BATCH]; //indices of the samples in which no opponent beats you so far
+  unsigned char tied[BATCH]; //whether an opponent ties with you in this sample
+
+  for(int i = 0; i < BATCH; i++) yourHand[i] = hand;
+  //the decks are never reset: each sample is a partial shuffle of the previous order of its deck, which is just as random
+  for(int i = 0; i < BATCH; i++)
+  for(int j = 0; j < numOther; j++)
+  {
+    decks[i * 52 + j] = (unsigned char)others[j];
+  }
 
-  int j = 0;
-  for(int i = 0; i < 52; i++)
+  for(int done = 0; done < numSamples; done += BATCH)
   {
-    int v = eval7_index(Card(i));
-    if(v == c[0] || v == c[1]) continue;
-    if(v == c[2] || v == c[3] || v == c[4]) continue;
-    if(j >= NUMOTHER) break;
+    int num = numSamples - done < BATCH ? numSamples - done : BATCH;
+
+    //stage 1: deal the board
+    for(int i = 0; i < num; i++)
+    {
+      unsigned char* deck = &decks[i * 52];
+      HandMask b = knownBoard;
+      for(int j = 0; j < numUnknown; j++)
+      {
+        int r = getRandomFast(j, numOther - 1);
+        std::swap(deck[j], deck[r]);
+        b |= HandMasksTable[deck[j]];
+      }
+      board[i] = b;
+    }
+
+    //stage 2: rank yourself, then each opponent. Like with early exit in the non batched loop, the
+    //next opponent is only dealt and ranked in the samples where nobody beat you yet.
+    rankColumn(yourVal, yourHand, board, num);
+    int numAlive = num;
+    for(int i = 0; i < num; i++) { alive[i] = i; tied[i] = 0; }
+    for(int j = 0; j < numOpponents && numAlive > 0; j++)
+    {
+      int first = numUnknown + j * 2; //deck position of the first card of this opponent
+      for(int k = 0; k < numAlive; k++)
+      {
+        int i = alive[k];
+        unsigned char* deck = &decks[i * 52];
+        int r1 = getRandomFast(first, numOther - 1);
+        std::swap(deck[first], deck[r1]);
+        int r2 = getRandomFast(first + 1, numOther - 1);
+        std::swap(deck[first + 1], deck[r2]);
+        opponent[i] = HandMasksTable[deck[first]] | HandMasksTable[deck[first + 1]];
+      }
+      numAlive = rankColumnAlive(alive, numAlive, tied, yourVal, opponent, board);
+    }
 
-    others[j] = v;
-    j++;
+    //stage 3: reduce
+    losses += num - numAlive;
+    for(int k = 0; k < numAlive; k++) ties += tied[alive[k]];
   }
 
+  wins = numSamples - ties - losses;
+}
+
+/*
+The win chance against N opponents, for any round. c must have room for 9 values
+and contain your hand in c[0] and c[1], then the numBoard known board cards.
+*/
+static void getWinChanceAgainstN(double& win, double& tie, double& lose, int* c, int numBoard
+                               , int numOpponents, int numSamples, SampleMethod method)
+{
+  win = tie = lose = 0.0;
+
+  int others[52];
+  int numOther = maskToCards(others, CARDMASK_ALL & ~cardsToMask(c, 2 + numBoard));
+
   int wins = 0;
   int ties = 0;
   int losses = 0;
 
-  for(int i = 0; i < numSamples; i++)
+  if(method == SM_STRATIFIED)
   {
-    shuffleN(others, NUMOTHER, 2 + numOpponents * 2); //the two extra table cards, and the cards of all opponents
-
-    c[5] = others[0];
-    c[6] = others[1];
-
-    int yourVal = eval7(&c[0]);
+    sampleStratified(wins, ties, losses, c, numBoard, others, numOther, numOpponents, numSamples);
+  }
+  else if(method == SM_BATCHED)
+  {
+    sampleBatched(wins, ties, losses, c, numBoard, others, numOther, numOpponents, numSamples);
+  }
+  else
+  {
+    int numDrawn = 5 - numBoard + numOpponents * 2; //the unknown table cards, and the cards of all opponents
 
-    int status = 2; //2: you win, 1: you tie, 0: you lose
+    Deck deck;
+    deck.setCards(others, numOther);
+    RandomFast random;
 
-    for(int j = 0; j < numOpponents; j++)
+    for(int i = 0; i < numSamples; i++)
     {
-      //opponents hand
-      c[7] = others[2 + j * 2];
-      c[8] = others[3 + j * 2];
+      deck.shuffle();
+      for(int j = 0; j < numDrawn; j++) deck.nextIndex(random);
 
-      int opponentVal = eval7(&c[2]);
-
-      if(opponentVal == yourVal) status = 1; //tie
-      else if(opponentVal > yourVal) { status = 0; break; } //lose, stop rest of loop.
+      int status = getStatusAgainstN(c, numBoard, deck.getDealt(), numOpponents);
+      if(status == 0) losses++;
+      else if(status == 1) ties++;
+      else wins++;
     }
-
-    if(status == 0) losses++;
-    else if(status == 1) ties++;
-    else wins++;
   }
 
   win = (double)wins / numSamples;
@@ -614,13 +708,24 @@ void getWinChanceAgainstNAtFlop(double& win, double& tie, double& lose
   lose = (double)losses / numSamples;
 }
 
-void getWinChanceAgainstNAtTurn(double& win, double& tie, double& lose
-                               , const Card& hand1, const Card& hand2
-                               , const Card& table1, const Card& table2, const Card& table3, const Card& table4
-                               , int numOpponents, int numSamples)
+void getWinChanceAgainstNAtPreFlop(double& win, double& tie, double& lose
+                                 , const Card& hand1, const Card& hand2
+                                 , int numOpponents, int numSamples, SampleMethod method)
 {
-  win = tie = lose = 0.0;
+  //an array of 9 values, set up to contain your hand, the 5 table cards, and then the randomly generated players hand
+  int c[9];
 
+  c[0] = eval7_index(hand1);
+  c[1] = eval7_index(hand2);
+
+  getWinChanceAgainstN(win, tie, lose, c, 0, numOpponents, numSamples, method);
+}
+
+void getWinChanceAgainstNAtFlop(double& win, double& tie, double& lose
+                               , const Card& hand1, const Card& hand2
+                               , const Card& table1, const Card& table2, const Card& table3
+                               , int numOpponents, int numSamples, SampleMethod method)
+{
   //an array of 9 values, set up to contain your hand, the 5 table cards, and then the randomly generated players hand
   int c[9];
 
@@ -629,67 +734,33 @@ void getWinChanceAgainstNAtTurn(double& win, double& tie, double& lose
   c[2] = eval7_index(table1);
   c[3] = eval7_index(table2);
   c[4] = eval7_index(table3);
-  c[5] = eval7_index(table4);
-
-  static const int NUMOTHER = 46;
-
-  int others[NUMOTHER];
-
-  int j = 0;
-  for(int i = 0; i < 52; i++)
-  {
-    int v = eval7_index(Card(i));
-    if(v == c[0] || v == c[1]) continue;
-    if(v == c[2] || v == c[3] || v == c[4] || v == c[5]) continue;
-    if(j >= NUMOTHER) break;
-
-    others[j] = v;
-    j++;
-  }
-
-  int wins = 0;
-  int ties = 0;
-  int losses = 0;
-
-  for(int i = 0; i < numSamples; i++)
-  {
-    shuffleN(others, NUMOTHER, 1 + numOpponents * 2); //the one extra table card, and the cards of all opponents
-
-    c[6] = others[0];
 
-    int yourVal = eval7(&c[0]);
-
-    int status = 2; //2: you win, 1: you tie, 0: you lose
-
-    for(int j = 0; j < numOpponents; j++)
-    {
-      //opponents hand
-      c[7] = others[1 + j * 2];
-      c[8] = others[2 + j * 2];
-
-      int opponentVal = eval7(&c[2]);
+  getWinChanceAgainstN(win, tie, lose, c, 3, numOpponents, numSamples, method);
+}
 
-      if(opponentVal == yourVal) status = 1; //tie
-      else if(opponentVal > yourVal) { status = 0; break; } //lose, stop rest of loop.
-    }
+void getWinChanceAgainstNAtTurn(double& win, double& tie, double& lose
+                               , const Card& hand1, const Card& hand2
+                               , const Card& table1, const Card& table2, const Card& table3, const Card& table4
+                               , int numOpponents, int numSamples, SampleMethod method)
+{
+  //an array of 9 values, set up to contain your hand, the 5 table cards, and then the randomly generated players hand
+  int c[9];
 
-    if(status == 0) losses++;
-    else if(status == 1) ties++;
-    else wins++;
-  }
+  c[0] = eval7_index(hand1);
+  c[1] = eval7_index(hand2);
+  c[2] = eval7_index(table1);
+  c[3] = eval7_index(table2);
+  c[4] = eval7_index(table3);
+  c[5] = eval7_index(table4);
 
-  win = (double)wins / numSamples;
-  tie = (double)ties / numSamples;
-  lose = (double)losses / numSamples;
+  getWinChanceAgainstN(win, tie, lose, c, 4, numOpponents, numSamples, method);
 }
 
 void getWinChanceAgainstNAtRiver(double& win, double& tie, double& lose
                                 , const Card& hand1, const Card& hand2
                                 , const Card& table1, const Card& table2, const Card& table3, const Card& table4, const Card& table5
-                                , int numOpponents, int numSamples)
+                                , int numOpponents, int numSamples, SampleMethod method)
 {
-  win = tie = lose = 0.0;
-
   //an array of 9 values, set up to contain your hand, the 5 table cards, and then the randomly generated players hand
   int c[9];
 
@@ -701,54 +772,7 @@ void getWinChanceAgainstNAtRiver(double& win, double& tie, double& lose
   c[5] = eval7_index(table4);
   c[6] = eval7_index(table5);
 
-  static const int NUMOTHER = 45;
-
-  int others[NUMOTHER];
-
-  int j = 0;
-  for(int i = 0; i < 52; i++)
-  {
-    int v = eval7_index(Card(i));
-    if(v == c[0] || v == c[1]) continue;
-    if(v == c[2] || v == c[3] || v == c[4] || v == c[5] || v == c[6]) continue;
-    if(j >= NUMOTHER) break;
-
-    others[j] = v;
-    j++;
-  }
-
-  int wins = 0;
-  int ties = 0;
-  int losses = 0;
-
-  for(int i = 0; i < numSamples; i++)
-  {
-    shuffleN(others, NUMOTHER,  numOpponents * 2); //the cards of all opponents
-
-    int yourVal = eval7(&c[0]);
-
-    int status = 2; //2: you win, 1: you tie, 0: you lose
-
-    for(int j = 0; j < numOpponents; j++)
-    {
-      //opponents hand
-      c[7] = others[0 + j * 2];
-      c[8] = others[1 + j * 2];
-
-      int opponentVal = eval7(&c[2]);
-
-      if(opponentVal == yourVal) status = 1; //tie
-      else if(opponentVal > yourVal) { status = 0; break; } //lose, stop rest of loop.
-    }
-
-    if(status == 0) losses++;
-    else if(status == 1) ties++;
-    else wins++;
-  }
-
-  win = (double)wins / numSamples;
-  tie = (double)ties / numSamples;
-  lose = (double)losses / numSamples;
+  getWinChanceAgainstN(win, tie, lose, c, 5, numOpponents, numSamples, method);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -827,8 +851,7 @@ ComboType eval7_category(int result)
 
 int eval7(const int* cards)
 {
-  static bool inited = false;
-  if(!inited) { PokerEval2::InitializeHandRankingTables(); inited = true; }
+  initPokerEval2();
 
   return (int)PokerEval2::RankHand( PokerEval2::HandMasksTable[cards[0]] | PokerEval2::HandMasksTable[cards[1]] |
                                     PokerEval2::HandMasksTable[cards[2]] | PokerEval2::HandMasksTable[cards[3]] |
@@ -860,19 +883,19 @@ int eval5(const int* cards)
   return 7462 - PokerEval::eval_5hand(cards); //subtracted from highest possible value, because higher is better in my case.
 }
 
+struct Eval5Deck
+{
+  int deck[52];
+  Eval5Deck() { PokerEval::init_deck(deck); }
+};
+
 int eval5_index(const Card& card)
 {
-  static bool inited = false;
-  static int deck[52];
-  if(!inited)
-  {
-    PokerEval::init_deck(deck);
-    inited = true;
-  }
+  static const Eval5Deck deck; //initialized only once, also if multiple threads get here at the same time
 
   int value = card.value + 13 * (int)card.suit - 2;
 
-  return deck[value];
+  return deck.deck[value];
 }
 
 ComboType eval5_category(int result)
@@ -977,27 +1000,27 @@ ComboType eval4_2_5_3_slow_category(int result)
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
-double getPotEquity(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards, int numOpponents, int numSamples)
+double getPotEquity(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards, int numOpponents, int numSamples, SampleMethod method)
 {
   double win = 0, tie = 0, lose = 0;
 
   if(boardCards.empty()) //pre-flop
   {
-    getWinChanceAgainstNAtPreFlop(win, tie, lose, holeCards[0], holeCards[1], numOpponents, numSamples);
+    getWinChanceAgainstNAtPreFlop(win, tie, lose, holeCards[0], holeCards[1], numOpponents, numSamples, method);
   }
   else if(boardCards.size() == 3) //flop
   {
-    getWinChanceAgainstNAtFlop(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], numOpponents, numSamples);
+    getWinChanceAgainstNAtFlop(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], numOpponents, numSamples, method);
   }
   else if(boardCards.size() == 4) //turn
   {
     if(numOpponents == 1) getWinChanceAgainst1AtTurn(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], boardCards[3]);
-    else getWinChanceAgainstNAtTurn(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], boardCards[3], numOpponents, numSamples);
+    else getWinChanceAgainstNAtTurn(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], boardCards[3], numOpponents, numSamples, method);
   }
   else if(boardCards.size() == 5) //river
   {
     if(numOpponents == 1) getWinChanceAgainst1AtRiver(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], boardCards[3], boardCards[4]);
-    else getWinChanceAgainstNAtRiver(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], boardCards[3], boardCards[4], numOpponents, numSamples);
+    else getWinChanceAgainstNAtRiver(win, tie, lose, holeCards[0], holeCards[1], boardCards[0], boardCards[1], boardCards[2], boardCards[3], boardCards[4], numOpponents, numSamples, method);
   }
 
   double result = win;
@@ -1075,6 +1098,39 @@ void testPlayers(int* wins, int* ties, int* losses
 
 }
 
+//called by the enumeration for every possible completion of the board, the unknown board cards are already in place in v
+struct KnownHandsCounter
+{
+  int* wins;
+  int* ties;
+  int* losses;
+  int* v;
+  int* val;
+  const int* holeCards1;
+  const int* holeCards2;
+  int numPlayers;
+  int count;
+
+  KnownHandsCounter(int* wins, int* ties, int* losses, int* v, int* val, const int* holeCards1, const int* holeCards2, int numPlayers)
+  : wins(wins)
+  , ties(ties)
+  , losses(losses)
+  , v(v)
+  , val(val)
+  , holeCards1(holeCards1)
+  , holeCards2(holeCards2)
+  , numPlayers(numPlayers)
+  , count(0)
+  {
+  }
+
+  void operator()(const int* /*unknown board cards, already in v*/)
+  {
+    testPlayers(wins, ties, losses, v, val, holeCards1, holeCards2, numPlayers);
+    count++;
+  }
+};
+
 bool getWinChanceWithKnownHands(std::vector<double>& win, std::vector<double>& tie, std::vector<double>& lose
                               , const std::vector<Card>& holeCards1
                               , const std::vector<Card>& holeCards2
@@ -1145,13 +1201,11 @@ bool getWinChanceWithKnownHands(std::vector<double>& win, std::vector<double>& t
   {
     count = numSamples;
 
-    //this is a memory structure made to easily have 7 cards in a row that can be evaluated, and can be shuffled at the locations where needed. It contains: 2 hand cards, 0-5 known board cards, and the unknown cards with the unknown board cards first (can be shuffled)
-    std::vector<int> v(2 + numBoard + numOther);
+    //7 cards in a row that can be evaluated: 2 hand cards (filled in by testPlayers), the known board cards, and then the randomly drawn unknown board cards
+    int v[7];
     for(int i = 0; i < numBoard; i++) v[2 + i] = boardCardsInt[i];
 
-    int* other = &v[2 + numBoard]; //cards other than the known ones
-
-
+    int other[52]; //cards other than the known ones
     for(int i = 0, j = 0; i < 52; i++)
     {
       if(flags[i])
@@ -1161,132 +1215,41 @@ bool getWinChanceWithKnownHands(std::vector<double>& win, std::vector<double>& t
       }
     }
 
-    for(int i = 0; i < numSamples; i++)
-    {
-      shuffleN(&other[0], numOther,  numUnknown); //the cards of all opponents
-      testPlayers(&wins[0], &ties[0], &losses[0], &v[0], &val[0], &holeCardsInt1[0], &holeCardsInt2[0], numPlayers);
-    }
-  }
-  else //do it exhaustively
-  {
-
-    //this is a memory structure made to easily have 7 cards in a row that can be evaluated, and can be shuffled at the locations where needed. It contains: 2 hand cards, 0-5 known board cards, and the unknown cards with the unknown board cards first (can be shuffled)
-    std::vector<int> others;
-    for(int i = 0; i < 52; i++) others.push_back(eval7_index(Card(i)));
-
-    int c[7];
+    Deck deck;
+    deck.setCards(other, numOther);
 
-    if(numBoard == 0)
-    {
-      for (int card1 = 0; card1 < numOther - 4; card1++)
-      {
-        c[2] = others[card1];
-        for (int card2 = card1 + 1; card2 < numOther - 3; card2++)
-        {
-          c[3] = others[card2];
-          for (int card3 = card2 + 1; card3 < numOther - 2; card3++)
-          {
-            c[4] = others[card3];
-            for (int card4 = card3 + 1; card4 < numOther - 1; card4++)
-            {
-              c[5] = others[card4];
-              for (int card5 = card4 + 1; card5 < numOther - 0; card5++)
-              {
-                c[6] = others[card5];
-                testPlayers(&wins[0], &ties[0], &losses[0], c, val, &holeCardsInt1[0], &holeCardsInt2[0], numPlayers);
-                count++;
-              }
-            }
-          }
-        }
-      }
-    }
-    else if(numBoard == 1)
-    {
-      c[2] = boardCardsInt[0];
+    //the random card offsets are generated in bulk, BATCH samples at a time: for the j-th card of every sample the range is the same
+    RandomLanes random(((uint64_t)getRandomUintFast() << 32) | getRandomUintFast());
+    uint32_t draws[5][BATCH];
 
-      for (int card1 = 0; card1 < numOther - 3; card1++)
-      {
-        c[3] = others[card1];
-        for (int card2 = card1 + 1; card2 < numOther - 2; card2++)
-        {
-          c[4] = others[card2];
-          for (int card3 = card2 + 1; card3 < numOther - 1; card3++)
-          {
-            c[5] = others[card3];
-            for (int card4 = card3 + 1; card4 < numOther - 0; card4++)
-            {
-              c[6] = others[card4];
-              testPlayers(&wins[0], &ties[0], &losses[0], c, val, &holeCardsInt1[0], &holeCardsInt2[0], numPlayers);
-              count++;
-            }
-          }
-        }
-      }
-    }
-    else if(numBoard == 2)
+    for(int i = 0; i < numSamples; i += BATCH)
     {
-      c[2] = boardCardsInt[0];
-      c[3] = boardCardsInt[1];
+      int num = std::min(BATCH, numSamples - i);
+      for(int j = 0; j < numUnknown; j++) random.fillBounded(draws[j], num, numOther - j);
 
-      for (int card1 = 0; card1 < numOther - 2; card1++)
+      for(int k = 0; k < num; k++)
       {
-        c[4] = others[card1];
-        for (int card2 = card1 + 1; card2 < numOther - 1; card2++)
-        {
-          c[5] = others[card2];
-          for (int card3 = card2 + 1; card3 < numOther - 0; card3++)
-          {
-            c[6] = others[card3];
-            testPlayers(&wins[0], &ties[0], &losses[0], c, val, &holeCardsInt1[0], &holeCardsInt2[0], numPlayers);
-            count++;
-          }
-        }
+        deck.shuffle();
+        for(int j = 0; j < numUnknown; j++) v[2 + numBoard + j] = deck.nextIndexAt(draws[j][k]);
+        testPlayers(&wins[0], &ties[0], &losses[0], &v[0], &val[0], &holeCardsInt1[0], &holeCardsInt2[0], numPlayers);
       }
     }
-    else if(numBoard == 3)
+  }
+  else //do it exhaustively
+  {
+    CardMask remaining = 0;
+    for(int i = 0; i < 52; i++)
     {
-      c[2] = boardCardsInt[0];
-      c[3] = boardCardsInt[1];
-      c[4] = boardCardsInt[2];
-
-      for (int card1 = 0; card1 < numOther - 1; card1++)
-      {
-        c[5] = others[card1];
-        for (int card2 = card1 + 1; card2 < numOther - 0; card2++)
-        {
-          c[6] = others[card2];
-          testPlayers(&wins[0], &ties[0], &losses[0], c, val, &holeCardsInt1[0], &holeCardsInt2[0], numPlayers);
-          count++;
-        }
-      }
+      if(flags[i]) remaining |= cardToMask(eval7_index(Card(i)));
     }
-    else if(numBoard == 4)
-    {
-      c[2] = boardCardsInt[0];
-      c[3] = boardCardsInt[1];
-      c[4] = boardCardsInt[2];
-      c[5] = boardCardsInt[3];
 
-      for (int card1 = 0; card1 < numOther - 0; card1++)
-      {
-        c[6] = others[card1];
-        testPlayers(&wins[0], &ties[0], &losses[0], c, val, &holeCardsInt1[0], &holeCardsInt2[0], numPlayers);
-        count++;
-      }
-    }
-    else if(numBoard == 5)
-    {
-      c[2] = boardCardsInt[0];
-      c[3] = boardCardsInt[1];
-      c[4] = boardCardsInt[2];
-      c[5] = boardCardsInt[3];
-      c[6] = boardCardsInt[4];
-
-      testPlayers(&wins[0], &ties[0], &losses[0], c, val, &holeCardsInt1[0], &holeCardsInt2[0], numPlayers);
-      count++;
-    }
+    //7 cards in a row that can be evaluated: 2 hand cards (filled in by testPlayers), the known board cards, and then the unknown board cards
+    int c[7];
+    for(int i = 0; i < numBoard; i++) c[2 + i] = boardCardsInt[i];
 
+    KnownHandsCounter counter(&wins[0], &ties[0], &losses[0], c, val, &holeCardsInt1[0], &holeCardsInt2[0], numPlayers);
+    enumerateKSubsets(numUnknown, remaining, &c[2 + numBoard], counter);
+    count = counter.count;
   }
 
   for(int i = 0; i < numPlayers; i++)
@@ -1298,3 +1261,232 @@ bool getWinChanceWithKnownHands(std::vector<double>& win, std::vector<double>& t
 
   return true;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+enum EquityKind
+{
+  EK_POT_EQUITY, //result of getPotEquity, in win
+  EK_WIN_CHANCE //result of getWinChanceAgainstN...
+};
+
+struct EquityKey
+{
+  uint64_t cards; //the canonical cards, see getCanonicalCards
+  int numOpponents;
+  int numSamples;
+  int method;
+  int kind;
+
+  bool operator<(const EquityKey& other) const
+  {
+    if(cards != other.cards) return cards < other.cards;
+    if(numOpponents != other.numOpponents) return numOpponents < other.numOpponents;
+    if(numSamples != other.numSamples) return numSamples < other.numSamples;
+    if(method != other.method) return method < other.method;
+    return kind < other.kind;
+  }
+};
+
+struct EquityResult
+{
+  double win;
+  double tie;
+  double lose;
+};
+
+/*
+Least recently used cache. The list has the most recently used entry at the front,
+the map finds the list entry of a key.
+*/
+struct EquityCache
+{
+  typedef std::list<std::pair<EquityKey, EquityResult> > List;
+  typedef std::map<EquityKey, List::iterator> Map;
+
+  List list;
+  Map map;
+  size_t capacity;
+  size_t hits;
+  size_t misses;
+
+  EquityCache()
+  : capacity(4096)
+  , hits(0)
+  , misses(0)
+  {
+  }
+
+  bool get(EquityResult& result, const EquityKey& key)
+  {
+    Map::iterator it = map.find(key);
+    if(it == map.end())
+    {
+      misses++;
+      return false;
+    }
+    hits++;
+    list.splice(list.begin(), list, it->second); //move to front
+    result = it->second->second;
+    return true;
+  }
+
+  void put(const EquityKey& key, const EquityResult& result)
+  {
+    if(capacity == 0) return;
+    Map::iterator it = map.find(key);
+    if(it != map.end())
+    {
+      list.splice(list.begin(), list, it->second);
+      return;
+    }
+    list.push_front(std::make_pair(key, result));
+    map[key] = list.begin();
+    shrink();
+  }
+
+  void shrink()
+  {
+    while(map.size() > capacity)
+    {
+      map.erase(list.back().first);
+      list.pop_back();
+    }
+  }
+};
+
+static thread_local EquityCache equityCache; //each thread has its own, so no locking is needed
+
+/*
+Gives the cards as one integer that is the same for all hands that have the same
+equity: the order of the hole cards and the order of the board cards don't matter,
+and neither do the names of the suits. Of all 24 ways to rename the suits, the one
+giving the smallest integer is used. Each card takes 6 bits: hole cards first, then
+the board cards, then the amount of board cards.
+*/
+static uint64_t getCanonicalCards(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards)
+{
+  static const int perms[24][4] =
+  {
+    {0,1,2,3}, {0,1,3,2}, {0,2,1,3}, {0,2,3,1}, {0,3,1,2}, {0,3,2,1},
+    {1,0,2,3}, {1,0,3,2}, {1,2,0,3}, {1,2,3,0}, {1,3,0,2}, {1,3,2,0},
+    {2,0,1,3}, {2,0,3,1}, {2,1,0,3}, {2,1,3,0}, {2,3,0,1}, {2,3,1,0},
+    {3,0,1,2}, {3,0,2,1}, {3,1,0,2}, {3,1,2,0}, {3,2,0,1}, {3,2,1,0}
+  };
+
+  int numBoard = (int)boardCards.size();
+  int values[7];
+  int suits[7];
+  for(int i = 0; i < 2; i++)
+  {
+    values[i] = holeCards[i].getValue() - 2;
+    suits[i] = (int)holeCards[i].getSuit();
+  }
+  for(int i = 0; i < numBoard; i++)
+  {
+    values[2 + i] = boardCards[i].getValue() - 2;
+    suits[2 + i] = (int)boardCards[i].getSuit();
+  }
+
+  uint64_t best = 0;
+  for(int p = 0; p < 24; p++)
+  {
+    int c[7];
+    for(int i = 0; i < 2 + numBoard; i++) c[i] = perms[p][suits[i]] * 13 + values[i];
+
+    //sort the hole cards and the board cards separately (insertion sort, they're tiny)
+    if(c[0] > c[1]) std::swap(c[0], c[1]);
+    for(int i = 3; i < 2 + numBoard; i++)
+    {
+      for(int j = i; j > 2 && c[j - 1] > c[j]; j--) std::swap(c[j - 1], c[j]);
+    }
+
+    uint64_t key = 0;
+    for(int i = 0; i < 2 + numBoard; i++) key = (key << 6) | c[i];
+    key = (key << 3) | numBoard;
+
+    if(p == 0 || key < best) best = key;
+  }
+
+  return best;
+}
+
+static EquityKey makeEquityKey(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards, int numOpponents, int numSamples, SampleMethod method, EquityKind kind)
+{
+  EquityKey key;
+  key.cards = getCanonicalCards(holeCards, boardCards);
+  key.numOpponents = numOpponents;
+  key.numSamples = numSamples;
+  key.method = (int)method;
+  key.kind = (int)kind;
+  return key;
+}
+
+double getPotEquityCached(const std::vector<Card>& holeCards, const std::vector<Card>& boardCards, int numOpponents, int numSamples, SampleMethod method)
+{
+  EquityKey key = makeEquityKey(holeCards, boardCards, numOpponents, numSamples, method, EK_POT_EQUITY);
+  EquityResult result;
+  if(equityCache.get(result, key)) return result.win;
+
+  result.win = getPotEquity(holeCards, boardCards, numOpponents, numSamples, method);
+  result.tie = result.lose = 0.0;
+  equityCache.put(key, result);
+  return result.win;
+}
+
+void getWinChanceAgainstNCached(double& win, double& tie, double& lose
+                              , const std::vector<Card>& holeCards, const std::vector<Card>& boardCards
+                              , int numOpponents, int numSamples, SampleMethod method)
+{
+  EquityKey key = makeEquityKey(holeCards, boardCards, numOpponents, numSamples, method, EK_WIN_CHANCE);
+  EquityResult result;
+  if(!equityCache.get(result, key))
+  {
+    const std::vector<Card>& h = holeCards;
+    const std::vector<Card>& b = boardCards;
+    win = tie = lose = 0.0;
+    if(b.empty()) getWinChanceAgainstNAtPreFlop(win, tie, lose, h[0], h[1], numOpponents, numSamples, method);
+    else if(b.size() == 3) getWinChanceAgainstNAtFlop(win, tie, lose, h[0], h[1], b[0], b[1], b[2], numOpponents, numSamples, method);
+    else if(b.size() == 4) getWinChanceAgainstNAtTurn(win, tie, lose, h[0], h[1], b[0], b[1], b[2], b[3], numOpponents, numSamples, method);
+    else if(b.size() == 5) getWinChanceAgainstNAtRiver(win, tie, lose, h[0], h[1], b[0], b[1], b[2], b[3], b[4], numOpponents, numSamples, method);
+    result.win = win;
+    result.tie = tie;
+    result.lose = lose;
+    equityCache.put(key, result);
+  }
+
+  win = result.win;
+  tie = result.tie;
+  lose = result.lose;
+}
+
+EquityCacheStats getEquityCacheStats()
+{
+  EquityCacheStats result;
+  result.hits = equityCache.hits;
+  result.misses = equityCache.misses;
+  result.size = equityCache.map.size();
+  result.capacity = equityCache.capacity;
+  return result;
+}
+
+void setEquityCacheCapacity(size_t capacity)
+{
+  equityCache.capacity = capacity;
+  equityCache.shrink();
+}
+
+void clearEquityCache()
+{
+  equityCache.list.clear();
+  equityCache.map.clear();
+  equityCache.hits = 0;
+  equityCache.misses = 0;
+}
@@ -25,32 +25,37 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #include "os.h"
 
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+/*
+getOSRandom fills the buffer with true-random bytes from the operating system. This is slow,
+so it is only used to seed (and now and then reseed) the ChaCha20 generator below.
+*/
 
 #if defined(_WIN32)
 
 #include <windows.h>
 
-unsigned int getRandomUint()
+static void getOSRandom(unsigned char* buffer, size_t size)
 {
-  unsigned int r;
+  bool ok = false;
 
   HMODULE hLib=LoadLibrary("ADVAPI32.DLL");
   if(hLib) {
     BOOLEAN (APIENTRY *pfn)(void*, ULONG) =
         (BOOLEAN (APIENTRY *)(void*,ULONG))GetProcAddress(hLib,"SystemFunction036");
     if(pfn) {
-      char buff[4];
-      ULONG ulCbBuff = sizeof(buff);
-      if(pfn(buff,ulCbBuff)) {
-        // use buff full of random goop
-        r = buff[0] + 256 * buff[1] + 256 * 256 * buff[2] + 256 * 256 * 256 * buff[3];
-      }
+      if(pfn(buffer, (ULONG)size)) ok = true;
     }
 
     FreeLibrary(hLib);
   }
 
-  return r;
+  if(!ok) {
+    std::cerr << "SystemFunction036 failed! Need a random source to operate. Quitting program." << std::endl;
+    std::exit(1);
+  }
 }
 
 // TODO: OS_UNKNOWN may not have /dev/urandom, provide alternative implementation
@@ -58,22 +63,154 @@ unsigned int getRandomUint()
 
 #include <string>
 #include <fstream>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/syscall.h>
 
-unsigned int getRandomUint()
+static void getOSRandom(unsigned char* buffer, size_t size)
 {
-  unsigned int r;
-  static std::string filename = "/dev/urandom";
-  static std::ifstream file(filename.c_str(), std::ios::in|std::ios::binary|std::ios::ate);
-  if(!file) {
-    std::cerr << "no /dev/urandom found! Need a random source to operate. Quitting program." << std::endl;
-    std::exit(1);
+  size_t done = 0;
+
+#if defined(SYS_getrandom)
+  //the getrandom system call (Linux 3.17 and later), no file needed
+  while(done < size)
+  {
+    long n = syscall(SYS_getrandom, buffer + done, size - done, 0);
+    if(n > 0) done += n;
+    else if(n < 0 && errno == EINTR) continue;
+    else break; //not supported by this kernel, use /dev/urandom instead
+  }
+#endif
+
+  if(done < size)
+  {
+    std::ifstream file("/dev/urandom", std::ios::in|std::ios::binary);
+    if(!file) {
+      std::cerr << "no /dev/urandom found! Need a random source to operate. Quitting program." << std::endl;
+      std::exit(1);
+    }
+    file.read((char*)(buffer + done), size - done);
+    if((size_t)file.gcount() != size - done) { //the buffer becomes the key, so a part that isn't read is not acceptable
+      std::cerr << "could not read /dev/urandom! Need a random source to operate. Quitting program." << std::endl;
+      std::exit(1);
+    }
   }
-  file.read((char*)(&r), sizeof(r));
-  return r;
 }
 
 #endif
 
+#define CHACHA_ROTL(a, b) (((a) << (b)) | ((a) >> (32 - (b))))
+#define CHACHA_QR(a, b, c, d)\
+{\
+  a += b; d ^= a; d = CHACHA_ROTL(d, 16);\
+  c += d; b ^= c; b = CHACHA_ROTL(b, 12);\
+  a += b; d ^= a; d = CHACHA_ROTL(d, 8);\
+  c += d; b ^= c; b = CHACHA_ROTL(b, 7);\
+}
+
+void chacha20Block(uint32_t out[16], const uint32_t in[16])
+{
+  uint32_t x[16];
+  for(int i = 0; i < 16; i++) x[i] = in[i];
+
+  for(int i = 0; i < 10; i++) //20 rounds, 2 per iteration
+  {
+    //column round
+    CHACHA_QR(x[0], x[4], x[8], x[12]);
+    CHACHA_QR(x[1], x[5], x[9], x[13]);
+    CHACHA_QR(x[2], x[6], x[10], x[14]);
+    CHACHA_QR(x[3], x[7], x[11], x[15]);
+    //diagonal round
+    CHACHA_QR(x[0], x[5], x[10], x[15]);
+    CHACHA_QR(x[1], x[6], x[11], x[12]);
+    CHACHA_QR(x[2], x[7], x[8], x[13]);
+    CHACHA_QR(x[3], x[4], x[9], x[14]);
+  }
+
+  for(int i = 0; i < 16; i++) out[i] = x[i] + in[i];
+}
+
+/*
+The state of the ChaCha20 generator. Each thread has its own one, so no locking is needed.
+
+The output is generated 16 blocks (1 KiB) at a time into a buffer. After each refill, the
+first 8 words of the new output replace the key and are not given out ("fast key erasure"),
+so values given out earlier can't be reconstructed from the state. Every RESEED_INTERVAL
+refills, new bytes from the operating system are mixed into the key.
+*/
+static const int CHACHA_BUFFER_BLOCKS = 16;
+static const int CHACHA_BUFFER_WORDS = CHACHA_BUFFER_BLOCKS * 16;
+static const int CHACHA_RESEED_INTERVAL = 1024; //reseed after every 1 MiB of output
+
+struct ChaChaRandom
+{
+  uint32_t state[16]; //constants, key (4-11), counter (12) and nonce (13-15)
+  uint32_t buffer[CHACHA_BUFFER_WORDS];
+  int pos; //next unused word of the buffer
+  int refillsUntilReseed;
+  bool seeded;
+};
+
+static thread_local ChaChaRandom chachaRandom; //zero initialized, so not seeded yet
+
+static void reseedChaCha(ChaChaRandom& r)
+{
+  uint32_t seed[11]; //key and nonce
+  getOSRandom((unsigned char*)seed, sizeof(seed));
+
+  if(!r.seeded)
+  {
+    r.state[0] = 0x61707865; //"expand 32-byte k"
+    r.state[1] = 0x3320646e;
+    r.state[2] = 0x79622d32;
+    r.state[3] = 0x6b206574;
+    r.state[12] = 0;
+    r.seeded = true;
+  }
+
+  for(int i = 0; i < 8; i++) r.state[4 + i] ^= seed[i];
+  for(int i = 0; i < 3; i++) r.state[13 + i] ^= seed[8 + i];
+
+  r.refillsUntilReseed = CHACHA_RESEED_INTERVAL;
+}
+
+static void refillChaCha(ChaChaRandom& r)
+{
+  if(!r.seeded || r.refillsUntilReseed <= 0) reseedChaCha(r);
+  r.refillsUntilReseed--;
+
+  for(int b = 0; b < CHACHA_BUFFER_BLOCKS; b++)
+  {
+    chacha20Block(&r.buffer[b * 16], r.state);
+    r.state[12]++;
+    if(r.state[12] == 0) r.state[13]++; //use part of the nonce as extra counter bits
+  }
+
+  for(int i = 0; i < 8; i++) r.state[4 + i] = r.buffer[i];
+  r.pos = 8;
+}
+
+static thread_local RandomStream* randomStream = 0;
+
+void setRandomStream(RandomStream* stream)
+{
+  randomStream = stream;
+}
+
+RandomStream* getRandomStream()
+{
+  return randomStream;
+}
+
+unsigned int getRandomUint()
+{
+  if(randomStream) return randomStream->getUint();
+
+  ChaChaRandom& r = chachaRandom;
+  if(r.pos <= 0 || r.pos >= CHACHA_BUFFER_WORDS) refillChaCha(r);
+  return r.buffer[r.pos++];
+}
+
 double getRandom()
 {
   return getRandomUint() / 4294967296.0;
@@ -81,12 +218,63 @@ double getRandom()
 
 int getRandom(int low, int high)
 {
-  return getRandomUint() % (high - low + 1) + low;
+  RandomSlow random;
+  return getRandomBounded(random, high - low + 1) + low;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+RandomStream::RandomStream()
+{
+  seed(0, 0);
+}
+
+RandomStream::RandomStream(uint64_t seed, uint64_t stream)
+{
+  this->seed(seed, stream);
+}
+
+void RandomStream::seed(uint64_t seed, uint64_t stream)
+{
+  state[0] = 0x61707865; //"expand 32-byte k"
+  state[1] = 0x3320646e;
+  state[2] = 0x79622d32;
+  state[3] = 0x6b206574;
+  state[4] = (uint32_t)seed;
+  state[5] = (uint32_t)(seed >> 32);
+  for(int i = 6; i < 12; i++) state[i] = 0;
+  state[12] = state[13] = 0; //64-bit block counter
+  state[14] = (uint32_t)stream;
+  state[15] = (uint32_t)(stream >> 32);
+  pos = 16;
+}
+
+unsigned int RandomStream::getUint()
+{
+  if(pos >= 16)
+  {
+    chacha20Block(buffer, state);
+    state[12]++;
+    if(state[12] == 0) state[13]++;
+    pos = 0;
+  }
+  return buffer[pos++];
+}
+
+double RandomStream::get()
+{
+  return getUint() / 4294967296.0;
+}
+
+int RandomStream::get(int low, int high)
+{
+  return getRandomBounded(*this, high - low + 1) + low;
 }
 
+////////////////////////////////////////////////////////////////////////////////
 
-static unsigned int m_w = 1;
-static unsigned int m_z = 2;
+static thread_local unsigned int m_w = 1; //each thread has its own state, so that seedRandomFast is reproducible per thread
+static thread_local unsigned int m_z = 2;
 
 //"Multiply-With-Carry" generator of G. Marsaglia
 unsigned int getRandomUintFast()
@@ -116,5 +304,162 @@ double getRandomFast()
 
 int getRandomFast(int low, int high)
 {
-  return getRandomUintFast() % (high - low + 1) + low;
+  RandomFast random;
+  return getRandomBounded(random, high - low + 1) + low;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+
+static inline uint32_t rotl32(uint32_t x, int k)
+{
+  return (x << k) | (x >> (32 - k));
+}
+
+//one step of a single xoshiro128** state
+static void xoshiroNext(uint32_t s[4])
+{
+  uint32_t t = s[1] << 9;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl32(s[3], 11);
+}
+
+//moves a single xoshiro128** state 2^64 steps further
+static void xoshiroJump(uint32_t s[4])
+{
+  static const uint32_t JUMP[4] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+
+  uint32_t t[4] = { 0, 0, 0, 0 };
+  for(int i = 0; i < 4; i++)
+  {
+    for(int b = 0; b < 32; b++)
+    {
+      if(JUMP[i] & (1u << b))
+      {
+        for(int j = 0; j < 4; j++) t[j] ^= s[j];
+      }
+      xoshiroNext(s);
+    }
+  }
+  for(int j = 0; j < 4; j++) s[j] = t[j];
+}
+
+RandomLanes::RandomLanes(uint64_t seed)
+{
+  this->seed(seed);
+}
+
+void RandomLanes::seed(uint64_t seed)
+{
+  //splitmix64 to turn the seed into a state that isn't all zeros
+  uint32_t s[4];
+  for(int i = 0; i < 2; i++)
+  {
+    seed += 0x9e3779b97f4a7c15ULL;
+    uint64_t z = seed;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z ^= z >> 31;
+    s[i * 2 + 0] = (uint32_t)z;
+    s[i * 2 + 1] = (uint32_t)(z >> 32);
+  }
+
+  for(int i = 0; i < LANES; i++)
+  {
+    s0[i] = s[0];
+    s1[i] = s[1];
+    s2[i] = s[2];
+    s3[i] = s[3];
+    xoshiroJump(s);
+  }
+
+  pos = LANES * 8;
+}
+
+void RandomLanes::jumpLanes()
+{
+  for(int i = 0; i < LANES; i++)
+  {
+    uint32_t s[4] = { s0[i], s1[i], s2[i], s3[i] };
+    xoshiroJump(s);
+    s0[i] = s[0];
+    s1[i] = s[1];
+    s2[i] = s[2];
+    s3[i] = s[3];
+  }
+}
+
+void RandomLanes::jump()
+{
+  for(int i = 0; i < LANES; i++) jumpLanes();
+  pos = LANES * 8;
+}
+
+void RandomLanes::fill(uint32_t* out, size_t num)
+{
+  //the state is copied to local arrays, so that the compiler knows out doesn't overlap with it and can keep it in SIMD registers
+  uint32_t a[LANES], b[LANES], c[LANES], d[LANES];
+  for(int l = 0; l < LANES; l++)
+  {
+    a[l] = s0[l];
+    b[l] = s1[l];
+    c[l] = s2[l];
+    d[l] = s3[l];
+  }
+
+  for(size_t i = 0; i < num; i += LANES)
+  {
+    uint32_t values[LANES];
+
+    //one step of every lane, written without dependencies between the lanes so that the compiler can vectorize it
+    for(int l = 0; l < LANES; l++)
+    {
+      values[l] = rotl32(b[l] * 5, 7) * 9;
+      uint32_t t = b[l] << 9;
+      c[l] ^= a[l];
+      d[l] ^= b[l];
+      b[l] ^= c[l];
+      a[l] ^= d[l];
+      c[l] ^= t;
+      d[l] = rotl32(d[l], 11);
+    }
+
+    if(i + LANES <= num) std::memcpy(out + i, values, sizeof(values)); //fixed size, so this becomes a few vector stores
+    else std::memcpy(out + i, values, (num - i) * sizeof(uint32_t)); //the last few values, if num isn't a multiple of LANES
+  }
+
+  for(int l = 0; l < LANES; l++)
+  {
+    s0[l] = a[l];
+    s1[l] = b[l];
+    s2[l] = c[l];
+    s3[l] = d[l];
+  }
+}
+
+void RandomLanes::fillBounded(uint32_t* out, size_t num, unsigned int range)
+{
+  fill(out, num);
+
+  //multiply-shift like getRandomBounded, with the division for the threshold done once for all values
+  uint32_t threshold = (0u - range) % range;
+  for(size_t i = 0; i < num; i++)
+  {
+    uint64_t m = (uint64_t)out[i] * range;
+    out[i] = (uint32_t)(m >> 32);
+    if((uint32_t)m < threshold) out[i] = getRandomBounded(*this, range); //rare
+  }
+}
+
+unsigned int RandomLanes::getUint()
+{
+  if(pos >= LANES * 8)
+  {
+    fill(buffer, LANES * 8);
+    pos = 0;
+  }
+  return buffer[pos++];
+}
@@ -22,8 +22,16 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
-//these methods use the true-random facilities provided by the operating system (non blocking, so not necessarily every returned value is true random!)
-//it uses SystemFunction036 on Windows, /dev/urandom on Linux.
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+These methods give cryptographically secure random numbers. They come from a ChaCha20
+stream cipher, which is seeded with true-random bytes from the operating system (the
+getrandom system call or /dev/urandom on Linux, SystemFunction036 on Windows), and
+reseeded from it after every MiB of output. The random numbers are generated in a buffer,
+so most calls don't do more than reading from it. Each thread has its own generator.
+*/
 unsigned int getRandomUint();
 double getRandom(); //returns random double in range 0.0-1.0
 int getRandom(int low, int high); //returns random in the given range. high is included.
@@ -35,3 +43,123 @@ int getRandomFast(int low, int high); //returns random in the given range. high
 
 void seedRandomFast(unsigned int seed1, unsigned int seed2);
 void seedRandomFastWithRandomSlow(); //seed the fast random generator, with two values from the slow random generator.
+
+//the functions above as random generator objects, for templated code that takes any generator with a getUint function (like RandomStream below)
+struct RandomSlow
+{
+  unsigned int getUint() { return getRandomUint(); }
+};
+
+struct RandomFast
+{
+  unsigned int getUint() { return getRandomUintFast(); }
+};
+
+/*
+Unbiased random integer in range 0 to range - 1, from any generator with a getUint function.
+
+This is Lemire's multiply-shift method: the high 32 bits of a 32-bit random value times
+range are the result. That alone gives a tiny bias (like modulo does), so values of the low
+32 bits that would cause it are rejected and drawn again. Rejection happens with a chance of
+less than range / 2^32, and the division that computes the threshold is only done then, so
+normally no division is done at all.
+*/
+template<typename Random>
+unsigned int getRandomBounded(Random& random, unsigned int range)
+{
+  uint64_t m = (uint64_t)random.getUint() * range;
+  uint32_t low = (uint32_t)m;
+  if(low < range)
+  {
+    uint32_t threshold = (0u - range) % range; //2^32 mod range
+    while(low < threshold)
+    {
+      m = (uint64_t)random.getUint() * range;
+      low = (uint32_t)m;
+    }
+  }
+  return (unsigned int)(m >> 32);
+}
+
+//The ChaCha20 block function (20 rounds, as in RFC 8439): out is the keystream block for the state in (constants, key, counter and nonce).
+void chacha20Block(uint32_t out[16], const uint32_t in[16]);
+
+/*
+A seedable random number stream, for when a run must be reproducible (e.g. to replay a
+game exactly for profiling or regression tests). It is the ChaCha20 keystream with the
+seed as key and the stream id as nonce: the same seed and id always give the same values,
+and streams with a different id (or seed) are independent of each other.
+*/
+class RandomStream
+{
+  public:
+    RandomStream(); //seed 0, stream 0
+    RandomStream(uint64_t seed, uint64_t stream);
+
+    void seed(uint64_t seed, uint64_t stream); //restarts the stream
+
+    unsigned int getUint();
+    double get(); //returns random double in range 0.0-1.0
+    int get(int low, int high); //returns random in the given range. high is included.
+
+  private:
+    uint32_t state[16];
+    uint32_t buffer[16];
+    int pos; //next unused word of the buffer
+};
+
+/*
+While a stream is set, getRandomUint, getRandom and getRandom(low, high) on this thread
+return values from that stream instead of from the OS-seeded generator. Code that uses the
+global functions (like the AI's and Deck::shuffle) can be made reproducible like this.
+Set it to null to go back to the normal generator.
+*/
+void setRandomStream(RandomStream* stream);
+RandomStream* getRandomStream();
+
+//Sets the random stream for as long as this object exists, and then restores the previous one.
+struct RandomStreamScope
+{
+  RandomStream* previous;
+
+  RandomStreamScope(RandomStream* stream) : previous(getRandomStream()) { setRandomStream(stream); }
+  ~RandomStreamScope() { setRandomStream(previous); }
+};
+
+/*
+Fast pseudo-random generator for generating many random numbers at once, e.g. for batched
+monte carlo sampling: 8 independent xoshiro128** generators (lanes) that are stepped together.
+The state is stored per variable for all lanes (structure of arrays), so the compiler turns
+each step into a few SIMD instructions.
+
+The lanes start 2^64 steps apart from each other in the xoshiro128** sequence, so they never
+overlap. jump() moves all lanes 8 * 2^64 steps further, to get another independent generator
+from the same seed (e.g. one per thread).
+
+Like getRandomFast, this is only pseudo-random, but much faster, and its period is 2^128.
+*/
+class RandomLanes
+{
+  public:
+    static const int LANES = 8;
+
+    RandomLanes(uint64_t seed = 0);
+    void seed(uint64_t seed);
+    void jump();
+
+    void fill(uint32_t* out, size_t num); //fills out with num uniform random 32-bit values
+    void fillBounded(uint32_t* out, size_t num, unsigned int range); //fills out with num unbiased random values in range 0 to range - 1
+
+    unsigned int getUint(); //one value at a time, for use with getRandomBounded, Deck::nextIndex, ...
+
+  private:
+    uint32_t s0[LANES];
+    uint32_t s1[LANES];
+    uint32_t s2[LANES];
+    uint32_t s3[LANES];
+
+    uint32_t buffer[LANES * 8];
+    int pos; //next unused value of the buffer
+
+    void jumpLanes(); //moves each lane 2^64 steps further
+};
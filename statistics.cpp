@@ -22,6 +22,7 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "statistics.h"
 
+#include <algorithm>
 #include <sstream>
 
 double PlayerStats::getVPIP () const
@@ -86,6 +87,23 @@ double PlayerStats::getAF() const
   return (double)((bets - preflop_bets) + (raises - preflop_raises)) / (double)(calls - preflop_calls);
 }
 
+double ActionStats::getVPIP() const
+{
+  return (double)deal_vpip / (double)deals;
+}
+
+double ActionStats::getPFR() const
+{
+  return (double)deal_pfr / (double)deals;
+}
+
+void ActionStats::add(const ActionStats& other)
+{
+  deals += other.deals; actions += other.actions;
+  folds += other.folds; checks += other.checks; calls += other.calls; bets += other.bets; raises += other.raises; allins += other.allins;
+  wins += other.wins; deal_vpip += other.deal_vpip; deal_pfr += other.deal_pfr;
+}
+
 std::string statisticsToString(const PlayerStats& stats)
 {
   std::stringstream ss;
@@ -94,6 +112,7 @@ std::string statisticsToString(const PlayerStats& stats)
   ss << "Rounds Seen: " << "flops: " << stats.flops_seen << ", turns: " << stats.turns_seen << ", rivers: " << stats.rivers_seen << ", showdowns: " << stats.showdowns_seen << std::endl;
   ss << "Wins: " << "total: " << stats.wins_total << ", showdown: " << stats.wins_showdown << ", bluff: " << stats.wins_bluff << std::endl;
   ss << "Chips: " << "won: " << stats.chips_won << ", lost: " << stats.chips_lost << ", bought: " << stats.chips_bought << ", forced bets: " << stats.forced_bets << std::endl;
+  ss << "All-in Adjusted: " << "chips won: " << stats.chips_won_allin_adjusted << ", deals: " << stats.allin_adjusted_deals << std::endl;
   //ss << "Actions: [Fold, Check, Call, Bet, Raise, All-In]" << std::endl;
   //ss << "Total: " << stats.folds << " " << stats.checks << " " << stats.calls << " " << stats.bets << " " << stats.raises << " " << stats.allins << std::endl;
   //ss << "Pre-flop: " << stats.preflop_folds << " " << stats.preflop_checks << " " << stats.preflop_calls << " " << stats.preflop_bets << " " << stats.preflop_raises << " " << stats.preflop_allins << std::endl;
@@ -102,6 +121,21 @@ std::string statisticsToString(const PlayerStats& stats)
   //ss << "River: " << stats.river_folds << " " << stats.river_checks << " " << stats.river_calls << " " << stats.river_bets << " " << stats.river_raises << " " << stats.river_allins << std::endl;
   ss << "Pre-Flop Stats: " << "VP$IP: " << stats.getVPIP() << ", PFR: " << stats.getPFR() << ", 3Bet: " << stats.get3BetPF() << std::endl;
   ss << "Post-Flop Stats: " << "AF: " << stats.getAF() << ", WSD: " << stats.getWSD() << ", WSDW: " << stats.getWSDW() << std::endl;
+  static const char* const POSITION_NAMES[NUM_POSITIONS] = { "SB", "BB", "early", "mid", "late" };
+  ss << "VP$IP/PFR per position:";
+  for(int i = 0; i < NUM_POSITIONS; i++)
+  {
+    const ActionStats& a = stats.positions[i];
+    if(a.deals > 0) ss << " " << POSITION_NAMES[i] << ": " << a.getVPIP() << "/" << a.getPFR();
+  }
+  ss << std::endl;
+  ss << "VP$IP/PFR per amount of players:";
+  for(int i = 0; i < NUM_TABLE_SIZES; i++)
+  {
+    const ActionStats& a = stats.table_sizes[i];
+    if(a.deals > 0) ss << " " << (i + 2) << ": " << a.getVPIP() << "/" << a.getPFR();
+  }
+  ss << std::endl;
   return ss.str();
 }
 
@@ -134,6 +168,25 @@ PlayerStats::PlayerStats(const std::string& name)
 
 
 
+void PlayerStats::add(const PlayerStats& other)
+{
+  deals += other.deals; actions += other.actions;
+  preflop_actions += other.preflop_actions; flop_actions += other.flop_actions; turn_actions += other.turn_actions; river_actions += other.river_actions;
+  chips_won += other.chips_won; chips_lost += other.chips_lost; chips_bought += other.chips_bought; forced_bets += other.forced_bets;
+  chips_won_allin_adjusted += other.chips_won_allin_adjusted; allin_adjusted_deals += other.allin_adjusted_deals;
+  flops_seen += other.flops_seen; turns_seen += other.turns_seen; rivers_seen += other.rivers_seen; showdowns_seen += other.showdowns_seen;
+  wins_total += other.wins_total; wins_showdown += other.wins_showdown; wins_bluff += other.wins_bluff;
+  folds += other.folds; checks += other.checks; calls += other.calls; bets += other.bets; raises += other.raises; allins += other.allins;
+  preflop_folds += other.preflop_folds; preflop_checks += other.preflop_checks; preflop_calls += other.preflop_calls; preflop_bets += other.preflop_bets; preflop_raises += other.preflop_raises; preflop_allins += other.preflop_allins;
+  flop_folds += other.flop_folds; flop_checks += other.flop_checks; flop_calls += other.flop_calls; flop_bets += other.flop_bets; flop_raises += other.flop_raises; flop_allins += other.flop_allins;
+  turn_folds += other.turn_folds; turn_checks += other.turn_checks; turn_calls += other.turn_calls; turn_bets += other.turn_bets; turn_raises += other.turn_raises; turn_allins += other.turn_allins;
+  river_folds += other.river_folds; river_checks += other.river_checks; river_calls += other.river_calls; river_bets += other.river_bets; river_raises += other.river_raises; river_allins += other.river_allins;
+  deal_first_action_folds += other.deal_first_action_folds; deal_checks += other.deal_checks; deal_calls += other.deal_calls; deal_bets += other.deal_bets; deal_raises += other.deal_raises;
+  deal_preflop_first_action_folds += other.deal_preflop_first_action_folds; deal_preflop_checks += other.deal_preflop_checks; deal_preflop_calls += other.deal_preflop_calls; deal_preflop_bets += other.deal_preflop_bets; deal_preflop_raises += other.deal_preflop_raises;
+  for(int i = 0; i < NUM_POSITIONS; i++) positions[i].add(other.positions[i]);
+  for(int i = 0; i < NUM_TABLE_SIZES; i++) table_sizes[i].add(other.table_sizes[i]);
+}
+
 TableStats::TableStats()
 {
   //set everything automatically to 0
@@ -141,25 +194,41 @@ TableStats::TableStats()
   for(size_t i = 0; i < sizeof(TableStats); i++) c[i] = 0;
 }
 
+void TableStats::add(const TableStats& other)
+{
+  deals += other.deals;
+  flops_seen += other.flops_seen;
+  turns_seen += other.turns_seen;
+  rivers_seen += other.rivers_seen;
+  joins += other.joins;
+  quits += other.quits;
+}
+
 
 StatKeeper::MyPlayerInfo::MyPlayerInfo(const std::string& name)
 : stats(name)
 , stack(0)
 , wager(0)
+, shown(false)
+, position(-1)
+, windowPos(0)
 {
 }
 
 StatKeeper::StatKeeper()
-: round(R_PRE_FLOP)
+: idStrings(0)
+, round(R_PRE_FLOP)
+, allinBoardSize(0)
+, allinAdjusted(false)
+, tableSize(0)
+, windowSize(100)
+, decay(0.99)
 {
 }
 
 StatKeeper::~StatKeeper()
 {
-  for(std::map<std::string, MyPlayerInfo*>::iterator it = statmap.begin(); it != statmap.end(); ++it)
-  {
-    delete it->second;
-  }
+  for(size_t i = 0; i < sortedPlayers.size(); i++) delete sortedPlayers[i];
 }
 
 void StatKeeper::getAllPlayers(std::vector<std::string>& players) const
@@ -170,82 +239,205 @@ void StatKeeper::getAllPlayers(std::vector<std::string>& players) const
   }
 }
 
-StatKeeper::MyPlayerInfo* StatKeeper::getPlayerStatsInternal(const std::string& player)
+bool StatKeeper::addAllInEquity()
 {
-  if(statmap.find(player) == statmap.end())
+  if(round != R_SHOWDOWN || allinBoardSize >= 5 || boardCards.size() < 5) return false;
+
+  std::vector<MyPlayerInfo*> players; //the players that are in the pot
+  std::vector<int> wager;
+  std::vector<bool> folded;
+  std::vector<Card> holeCards;
+
+  for(size_t i = 0; i < sortedPlayers.size(); i++)
+  {
+    MyPlayerInfo* p = sortedPlayers[i];
+    if(!p->joined || (p->folded && p->wager == 0)) continue;
+    if(!p->folded && !p->shown) return false; //can't calculate the equity without the cards
+
+    players.push_back(p);
+    wager.push_back(p->wager);
+    folded.push_back(p->folded);
+    holeCards.push_back(p->holeCard1);
+    holeCards.push_back(p->holeCard2);
+  }
+
+  if(players.size() < 2) return false;
+
+  std::vector<Card> board(boardCards.begin(), boardCards.begin() + allinBoardSize);
+  std::vector<double> wins;
+  getExpectedPotDivision(wins, wager, folded, holeCards, board);
+
+  for(size_t i = 0; i < players.size(); i++)
   {
-    statmap[player] = new MyPlayerInfo(player);
+    players[i]->stats.chips_won_allin_adjusted += wins[i];
+    players[i]->stats.allin_adjusted_deals++;
   }
 
-  return statmap[player];
+  return true;
 }
 
-void StatKeeper::onEvent(const Event& event)
+StatKeeper::MyPlayerInfo* StatKeeper::getPlayerStatsInternal(const std::string& player)
 {
-  MyPlayerInfo* info = 0;
-  if(!event.player.empty()) info = getPlayerStatsInternal(event.player);
-  PlayerStats* stats = &info->stats;
+  std::map<std::string, MyPlayerInfo*>::iterator it = statmap.find(player);
+  if(it != statmap.end()) return it->second;
+
+  MyPlayerInfo* info = new MyPlayerInfo(player);
+  statmap[player] = info;
+  sortedPlayers.insert(sortedPlayers.begin() + std::distance(statmap.begin(), statmap.find(player)), info); //same order as the map
+  return info;
+}
 
-  int* round_folds = 0;
-  int* round_checks = 0;
-  int* round_calls = 0;
-  int* round_bets = 0;
-  int* round_raises = 0;
-  int* round_allins = 0;
-  int* round_actions = 0;
-  if(round == R_PRE_FLOP)
+//the totals of the stats in the form of RecentStats, the counts of one deal are the difference of these before and after it
+static RecentStats<int> getRecentTotals(const PlayerStats& s)
+{
+  RecentStats<int> result;
+  result.deals = s.deals;
+  result.vpip = s.deal_preflop_calls + s.deal_preflop_bets + s.deal_preflop_raises;
+  result.pfr = s.deal_preflop_bets + s.deal_preflop_raises;
+  result.threebets = s.deal_preflop_raises;
+  result.flops_seen = s.flops_seen;
+  result.showdowns_seen = s.showdowns_seen;
+  result.wins_showdown = s.wins_showdown;
+  result.postflop_aggression = (s.bets - s.preflop_bets) + (s.raises - s.preflop_raises);
+  result.postflop_calls = s.calls - s.preflop_calls;
+  result.chips_won = s.chips_won;
+  result.chips_lost = s.chips_lost;
+  return result;
+}
+
+void StatKeeper::addRecentDeals()
+{
+  for(size_t i = 0; i < sortedPlayers.size(); i++)
   {
-    round_folds = &stats->preflop_folds;
-    round_checks = &stats->preflop_checks;
-    round_calls = &stats->preflop_calls;
-    round_bets = &stats->preflop_bets;
-    round_raises = &stats->preflop_raises;
-    round_allins = &stats->preflop_allins;
-    round_actions = &stats->preflop_actions;
+    MyPlayerInfo* p = sortedPlayers[i];
+    RecentStats<int> total = getRecentTotals(p->stats);
+    RecentStats<int> deal = total;
+    deal.add(p->total, -1);
+    p->total = total;
+    if(deal.deals == 0) continue; //not at the table during that deal
+
+    if(windowSize > 0)
+    {
+      if(p->window.size() < (size_t)windowSize) p->window.push_back(deal);
+      else
+      {
+        p->windowSum.add(p->window[p->windowPos], -1); //the oldest deal goes out
+        p->window[p->windowPos] = deal;
+        p->windowPos = (p->windowPos + 1) % p->window.size();
+      }
+      p->windowSum.add(deal, 1);
+    }
+
+    RecentStats<double> decayed;
+    decayed.add(p->decayed, decay);
+    decayed.add(deal, 1.0);
+    p->decayed = decayed;
   }
-  else if(round == R_FLOP)
+}
+
+const RecentStats<int>* StatKeeper::getWindowStats(const std::string& player) const
+{
+  std::map<std::string, MyPlayerInfo*>::const_iterator it = statmap.find(player);
+  return it == statmap.end() ? 0 : &it->second->windowSum;
+}
+
+const RecentStats<double>* StatKeeper::getDecayedStats(const std::string& player) const
+{
+  std::map<std::string, MyPlayerInfo*>::const_iterator it = statmap.find(player);
+  return it == statmap.end() ? 0 : &it->second->decayed;
+}
+
+void StatKeeper::setRecentStatsSettings(int windowSize, double decay)
+{
+  this->windowSize = windowSize;
+  this->decay = decay;
+  for(size_t i = 0; i < sortedPlayers.size(); i++) //the old windows can be bigger than the new size
   {
-    round_folds = &stats->flop_folds;
-    round_checks = &stats->flop_checks;
-    round_calls = &stats->flop_calls;
-    round_bets = &stats->flop_bets;
-    round_raises = &stats->flop_raises;
-    round_allins = &stats->flop_allins;
-    round_actions = &stats->flop_actions;
+    MyPlayerInfo* p = sortedPlayers[i];
+    p->window.clear();
+    p->windowPos = 0;
+    p->windowSum = RecentStats<int>();
   }
-  else if(round == R_TURN)
+}
+
+void StatKeeper::setPositions(const MyPlayerInfo* dealer)
+{
+  int num = (int)seats.size();
+  int d = -1;
+  for(int i = 0; i < num; i++) if(seats[i] == dealer) d = i;
+  if(d < 0) return;
+
+  int after = num - 2; //the players after the big blind, the dealer is the last of them
+  for(int i = 0; i < num; i++) //i: how many seats after the dealer
   {
-    round_folds = &stats->turn_folds;
-    round_checks = &stats->turn_checks;
-    round_calls = &stats->turn_calls;
-    round_bets = &stats->turn_bets;
-    round_raises = &stats->turn_raises;
-    round_allins = &stats->turn_allins;
-    round_actions = &stats->turn_actions;
+    MyPlayerInfo* p = seats[(d + i) % num];
+    if(num == 2) p->position = i == 0 ? POS_SB : POS_BB; //heads-up, the dealer is the small blind
+    else if(i == 1) p->position = POS_SB;
+    else if(i == 2) p->position = POS_BB;
+    else
+    {
+      int j = (i + num - 3) % num; //the order of acting pre-flop after the big blind
+      if(j >= after - 2) p->position = POS_LATE;
+      else if(j < (after - 1) / 2) p->position = POS_EARLY; //the first half of those before the late ones
+      else p->position = POS_MID;
+    }
   }
-  else if(round == R_RIVER)
+}
+
+StatKeeper::MyPlayerInfo* StatKeeper::getPlayerInfo(const Event& event)
+{
+  if(event.strings != idStrings) //events of another game, with other ids
   {
-    round_folds = &stats->river_folds;
-    round_checks = &stats->river_checks;
-    round_calls = &stats->river_calls;
-    round_bets = &stats->river_bets;
-    round_raises = &stats->river_raises;
-    round_allins = &stats->river_allins;
-    round_actions = &stats->river_actions;
+    playersById.clear();
+    seats.clear();
+    idStrings = event.strings;
   }
 
+  size_t id = (size_t)event.playerId;
+  if(id >= playersById.size()) playersById.resize(id + 1, 0);
+  if(!playersById[id]) playersById[id] = getPlayerStatsInternal(event.getPlayer());
+  return playersById[id];
+}
+
+//the per round stats, indexed by the Round (pre-flop to river)
+static int PlayerStats::* const ROUND_FOLDS[4] = { &PlayerStats::preflop_folds, &PlayerStats::flop_folds, &PlayerStats::turn_folds, &PlayerStats::river_folds };
+static int PlayerStats::* const ROUND_CHECKS[4] = { &PlayerStats::preflop_checks, &PlayerStats::flop_checks, &PlayerStats::turn_checks, &PlayerStats::river_checks };
+static int PlayerStats::* const ROUND_CALLS[4] = { &PlayerStats::preflop_calls, &PlayerStats::flop_calls, &PlayerStats::turn_calls, &PlayerStats::river_calls };
+static int PlayerStats::* const ROUND_BETS[4] = { &PlayerStats::preflop_bets, &PlayerStats::flop_bets, &PlayerStats::turn_bets, &PlayerStats::river_bets };
+static int PlayerStats::* const ROUND_RAISES[4] = { &PlayerStats::preflop_raises, &PlayerStats::flop_raises, &PlayerStats::turn_raises, &PlayerStats::river_raises };
+static int PlayerStats::* const ROUND_ALLINS[4] = { &PlayerStats::preflop_allins, &PlayerStats::flop_allins, &PlayerStats::turn_allins, &PlayerStats::river_allins };
+static int PlayerStats::* const ROUND_ACTIONS[4] = { &PlayerStats::preflop_actions, &PlayerStats::flop_actions, &PlayerStats::turn_actions, &PlayerStats::river_actions };
+
+void StatKeeper::onEvent(const Event& event)
+{
+  MyPlayerInfo* info = 0;
+  if(event.hasPlayer()) info = getPlayerInfo(event);
+  PlayerStats* stats = &info->stats;
+
+  int r = round < R_SHOWDOWN ? (int)round : (int)R_RIVER; //the betting events only come before the showdown
+  int PlayerStats::* round_folds = ROUND_FOLDS[r];
+  int PlayerStats::* round_checks = ROUND_CHECKS[r];
+  int PlayerStats::* round_calls = ROUND_CALLS[r];
+  int PlayerStats::* round_bets = ROUND_BETS[r];
+  int PlayerStats::* round_raises = ROUND_RAISES[r];
+  int PlayerStats::* round_allins = ROUND_ALLINS[r];
+  int PlayerStats::* round_actions = ROUND_ACTIONS[r];
+
   int numchips_placed = 0; //used for detecting all-in
+  int ActionStats::* action = 0; //the count of the action of this event, for the stats per position and table size
 
   switch(event.type)
   {
     case E_QUIT:
     {
       info->joined = false;
+      seats.erase(std::remove(seats.begin(), seats.end(), info), seats.end());
       break;
     }
     case E_JOIN:
     {
       info->joined = true;
+      if(std::find(seats.begin(), seats.end(), info) == seats.end()) seats.push_back(info);
       stats->chips_bought += event.chips;
       info->stack += event.chips;
       break;
@@ -258,29 +450,41 @@ void StatKeeper::onEvent(const Event& event)
     }
     case E_NEW_DEAL:
     {
+      addRecentDeals(); //the deal before this one is complete now, including its wins
+
       round = R_PRE_FLOP;
       highestBet = 0;
+      boardCards.clear();
+      allinBoardSize = 0;
+      allinAdjusted = false;
+      int dealPlayers = 0;
 
-      for(std::map<std::string, MyPlayerInfo*>::iterator it = statmap.begin(); it != statmap.end(); ++it)
+      for(size_t i = 0; i < sortedPlayers.size(); i++)
       {
-        MyPlayerInfo* p = it->second;
+        MyPlayerInfo* p = sortedPlayers[i];
         p->wager = 0;
         p->folded = false;
         p->deal_stat = 0;
         p->deal_preflop_stat = 0;
+        p->shown = false;
+        p->position = POS_LATE; //until E_DEALER gives the real one
         if(p->joined)
         {
           p->stats.deals++;
+          dealPlayers++;
         }
       }
 
+      tableSize = (dealPlayers < NUM_TABLE_SIZES + 2 ? dealPlayers : NUM_TABLE_SIZES + 1) - 2;
+      if(tableSize < 0) tableSize = 0;
+
       break;
     }
     case E_POT_DIVISION:
     {
-      for(std::map<std::string, MyPlayerInfo*>::iterator it = statmap.begin(); it != statmap.end(); ++it)
+      for(size_t i = 0; i < sortedPlayers.size(); i++)
       {
-        MyPlayerInfo* p = it->second;
+        MyPlayerInfo* p = sortedPlayers[i];
         if(p->joined)
         {
           int d = p->deal_stat;
@@ -296,12 +500,25 @@ void StatKeeper::onEvent(const Event& event)
           else if(d == 2) p->stats.deal_preflop_calls++;
           else if(d == 3) p->stats.deal_preflop_bets++;
           else if(d == 4) p->stats.deal_preflop_raises++;
+
+          ActionStats* a[2] = { &p->stats.positions[p->position], &p->stats.table_sizes[tableSize] };
+          for(int j = 0; j < 2; j++)
+          {
+            a[j]->deals++;
+            if(d >= 2) a[j]->deal_vpip++;
+            if(d >= 3) a[j]->deal_pfr++;
+          }
         }
       }
 
       break;
     }
-    case E_REVEAL_AI: stats->ai = event.ai; break; //this is the only event we can finally read the ai from!
+    case E_DEALER:
+    {
+      setPositions(info);
+      break;
+    }
+    case E_REVEAL_AI: stats->ai = event.getAI(); break; //this is the only event we can finally read the ai from!
     case E_SMALL_BLIND:
     {
       stats->forced_bets += event.chips;
@@ -326,9 +543,13 @@ void StatKeeper::onEvent(const Event& event)
     case E_FLOP:
     {
       round = R_FLOP;
-      for(std::map<std::string, MyPlayerInfo*>::iterator it = statmap.begin(); it != statmap.end(); ++it)
+      boardCards.clear();
+      boardCards.push_back(event.card1);
+      boardCards.push_back(event.card2);
+      boardCards.push_back(event.card3);
+      for(size_t i = 0; i < sortedPlayers.size(); i++)
       {
-        MyPlayerInfo* p = it->second;
+        MyPlayerInfo* p = sortedPlayers[i];
         if(!p->folded) p->stats.flops_seen++;
       }
       break;
@@ -336,9 +557,10 @@ void StatKeeper::onEvent(const Event& event)
     case E_TURN:
     {
       round = R_TURN;
-      for(std::map<std::string, MyPlayerInfo*>::iterator it = statmap.begin(); it != statmap.end(); ++it)
+      boardCards.push_back(event.card4);
+      for(size_t i = 0; i < sortedPlayers.size(); i++)
       {
-        MyPlayerInfo* p = it->second;
+        MyPlayerInfo* p = sortedPlayers[i];
         if(!p->folded) p->stats.turns_seen++;
       }
       break;
@@ -346,9 +568,10 @@ void StatKeeper::onEvent(const Event& event)
     case E_RIVER:
     {
       round = R_RIVER;
-      for(std::map<std::string, MyPlayerInfo*>::iterator it = statmap.begin(); it != statmap.end(); ++it)
+      boardCards.push_back(event.card5);
+      for(size_t i = 0; i < sortedPlayers.size(); i++)
       {
-        MyPlayerInfo* p = it->second;
+        MyPlayerInfo* p = sortedPlayers[i];
         if(!p->folded) p->stats.rivers_seen++;
       }
       break;
@@ -356,9 +579,9 @@ void StatKeeper::onEvent(const Event& event)
     case E_SHOWDOWN:
     {
       round = R_SHOWDOWN;
-      for(std::map<std::string, MyPlayerInfo*>::iterator it = statmap.begin(); it != statmap.end(); ++it)
+      for(size_t i = 0; i < sortedPlayers.size(); i++)
       {
-        MyPlayerInfo* p = it->second;
+        MyPlayerInfo* p = sortedPlayers[i];
         if(!p->folded) p->stats.showdowns_seen++;
       }
       break;
@@ -367,29 +590,32 @@ void StatKeeper::onEvent(const Event& event)
     {
       info->folded = true;
       stats->folds++;
-      (*round_folds)++;
+      (stats->*round_folds)++;
       stats->actions++;
-      (*round_actions)++;
+      (stats->*round_actions)++;
+      action = &ActionStats::folds;
       break;
     };
     case E_CHECK:
     {
       stats->checks++;
-      (*round_checks)++;
+      (stats->*round_checks)++;
       stats->actions++;
-      (*round_actions)++;
+      (stats->*round_actions)++;
       if(info->deal_stat < 1) info->deal_stat = 1;
       if(round == R_PRE_FLOP && info->deal_preflop_stat < 1) info->deal_preflop_stat = 1;
+      action = &ActionStats::checks;
       break;
     };
     case E_CALL:
     {
       stats->calls++;
-      (*round_calls)++;
+      (stats->*round_calls)++;
       stats->actions++;
-      (*round_actions)++;
+      (stats->*round_actions)++;
       if(info->deal_stat < 2) info->deal_stat = 2;
       if(round == R_PRE_FLOP && info->deal_preflop_stat < 2) info->deal_preflop_stat = 2;
+      action = &ActionStats::calls;
 
       numchips_placed = highestBet - info->wager;
 
@@ -402,20 +628,22 @@ void StatKeeper::onEvent(const Event& event)
       if(callAmount == 0) //bet
       {
         stats->bets++;
-        (*round_bets)++;
+        (stats->*round_bets)++;
         if(info->deal_stat < 3) info->deal_stat = 3;
       if(round == R_PRE_FLOP && info->deal_preflop_stat < 3) info->deal_preflop_stat = 3;
+        action = &ActionStats::bets;
       }
       else //raise
       {
         stats->raises++;
-        (*round_raises)++;
+        (stats->*round_raises)++;
         if(info->deal_stat < 4) info->deal_stat = 4;
       if(round == R_PRE_FLOP && info->deal_preflop_stat < 4) info->deal_preflop_stat = 4;
+        action = &ActionStats::raises;
       }
 
       stats->actions++;
-      (*round_actions)++;
+      (stats->*round_actions)++;
 
       numchips_placed = callAmount + event.chips; //since the event only contains the raise amount, we need to add the call amount to get the total amount of chips the player moved to the table
 
@@ -423,6 +651,13 @@ void StatKeeper::onEvent(const Event& event)
 
       break;
     }
+    case E_PLAYER_SHOWDOWN:
+    {
+      info->shown = true;
+      info->holeCard1 = event.card1;
+      info->holeCard2 = event.card2;
+      break;
+    }
     case E_WIN:
     {
       stats->chips_won += event.chips;
@@ -430,10 +665,33 @@ void StatKeeper::onEvent(const Event& event)
       stats->wins_total++;
       if(round == R_SHOWDOWN) stats->wins_showdown++;
       else stats->wins_bluff++;
+      action = &ActionStats::wins;
+
+      if(!allinAdjusted) allinAdjusted = addAllInEquity(); //all the showdown events come before the first win event
+      if(!allinAdjusted) stats->chips_won_allin_adjusted += event.chips;
+      break;
     }
     default: break;
   }
 
+  if(action)
+  {
+    ActionStats& a = stats->positions[info->position];
+    ActionStats& t = stats->table_sizes[tableSize];
+    (a.*action)++;
+    (t.*action)++;
+    if(action != &ActionStats::wins)
+    {
+      a.actions++;
+      t.actions++;
+    }
+  }
+
+  //the betting events: remember how much of the board was known at the last one
+  if(event.type >= E_SMALL_BLIND && event.type <= E_RAISE) allinBoardSize = (int)boardCards.size();
+
+  if(numchips_placed > 0 && numchips_placed > info->stack) numchips_placed = info->stack; //when calling all-in for less than the call amount
+
   if(numchips_placed > 0)
   {
     stats->chips_lost += numchips_placed;
@@ -443,7 +701,9 @@ void StatKeeper::onEvent(const Event& event)
     if(allin)
     {
       stats->allins++;
-      (*round_allins)++;
+      (stats->*round_allins)++;
+      stats->positions[info->position].allins++; //this includes the all-ins by the ante, of players that never act
+      stats->table_sizes[tableSize].allins++;
     }
   }
 }
@@ -460,3 +720,15 @@ const TableStats* StatKeeper::getTableStats() const
 {
   return &tableStats;
 }
+
+void StatKeeper::add(const StatKeeper& other)
+{
+  for(std::map<std::string, MyPlayerInfo*>::const_iterator it = other.statmap.begin(); it != other.statmap.end(); ++it)
+  {
+    MyPlayerInfo* info = getPlayerStatsInternal(it->first);
+    info->stats.add(it->second->stats);
+    if(info->stats.ai.empty()) info->stats.ai = it->second->stats.ai;
+  }
+
+  tableStats.add(other.tableStats);
+}
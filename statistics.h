@@ -27,9 +27,54 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <map>
 #include <string>
+#include <vector>
 
 //WARNING: all percentages are given as values in range 0.0-1.0, NOT values in range 0-100! So 1.0 means 100%.
 
+/*
+The position of a player in a deal, for the statistics per position. Early, mid and late are the
+players after the big blind, in the order in which they act pre-flop: late are the last two (the
+dealer and the one before him), the others are split in two halves. With 2 players there are only
+the small and big blind, and the dealer is the small blind.
+*/
+enum StatPosition
+{
+  POS_SB,
+  POS_BB,
+  POS_EARLY,
+  POS_MID,
+  POS_LATE,
+  NUM_POSITIONS
+};
+
+static const int NUM_TABLE_SIZES = 9; //the statistics per amount of players at the table are for 2 to 10 players, more than 10 counts as 10
+
+/*
+The counts of a player for one position, or for one amount of players at the table. The counts
+mean the same as those of PlayerStats, and the sum of a count over all positions (or all table
+sizes) is the count of PlayerStats.
+*/
+struct ActionStats
+{
+  int deals;
+  int actions;
+  int folds;
+  int checks;
+  int calls;
+  int bets;
+  int raises;
+  int allins;
+  int wins;
+
+  int deal_vpip; //deals in which the player voluntarily put money in the pot pre-flop, like deal_preflop_calls + deal_preflop_bets + deal_preflop_raises of PlayerStats
+  int deal_pfr; //deals in which the player bet or raised pre-flop
+
+  double getVPIP() const;
+  double getPFR() const;
+
+  void add(const ActionStats& other);
+};
+
 struct PlayerStats
 {
   PlayerStats(const std::string& name);
@@ -51,6 +96,16 @@ struct PlayerStats
   int chips_bought; //how much buy-in
   int forced_bets; //how much paid in blinds and antes
 
+  /*
+  All-in adjusted version of chips_won. When all players that didn't fold are all-in before the river,
+  the chips the player gets from the pot on average over all possible runouts (the all-in equity) are
+  counted here instead of the chips the player really got. In all other deals, this is the same as
+  chips_won. Comparing chips_won_allin_adjusted - chips_lost between players removes much of the luck
+  of the cards, so less deals are needed to see which one plays better.
+  */
+  double chips_won_allin_adjusted;
+  int allin_adjusted_deals; //in how many deals of this player chips_won_allin_adjusted used the all-in equity
+
   int flops_seen; //how many times this player actively reached the flop
   int turns_seen; //how many times this player actively reached the turn
   int rivers_seen; //how many times this player actively reached the river
@@ -142,11 +197,15 @@ struct PlayerStats
   int deal_preflop_bets;
   int deal_preflop_raises; //this are the RE-raises before the flop, a.k.a. the 3bets (or 4bets or higher)
 
-  //todo: add action statistics per position: sb, bb, early, mid, late
+  /*
+  The counts per position and per amount of players at the table, as fixed arrays so that they
+  need no lookup and no allocation. Index the positions with StatPosition, and the table sizes
+  with the amount of players minus 2 (so index 0 is heads-up).
+  */
+  ActionStats positions[NUM_POSITIONS];
+  ActionStats table_sizes[NUM_TABLE_SIZES];
 
   //todo: add statistics about starting hands of player (connecters, pocket pairs, ...) if that info is known.
-
-  //todo: add statistics about the amount of players at the table during the actions, wins, ...
 
   //Pre-Flop statistics deduced from the above values
   double getVPIP () const; //Voluntary Put Money In Pot: returned as value in range 0.0-1.0. Number of times player voluntarily called or raised at least once during a deal.
@@ -157,6 +216,62 @@ struct PlayerStats
   double getWSD() const; //Went To ShowDown: showdowns seen percentage (as value 0.0-1.0)
   double getWSDW() const; //Went To ShowDown and Won (percentages of showdowns won): as percentage (as value 0.0-1.0)
   double getAF() const; //Aggression Factor. Larger means more aggressive, smaller means more passive. Measured only after the flop.
+
+  void add(const PlayerStats& other); //adds all the counts of other to this one (e.g. the stats of the same player at another table). The name and ai are not changed.
+};
+
+/*
+The counts of a player over his recent deals only, to see how a player plays lately (e.g. when he
+changes gears), rather than over the whole game like PlayerStats. The counts and statistics mean the
+same as those of PlayerStats, but the statistics are 0 instead of undefined when dividing by 0.
+T is int for the counts of the last N deals, and double for the exponentially decayed counts.
+*/
+template<typename T>
+struct RecentStats
+{
+  T deals;
+  T vpip; //deals in which the player voluntarily put money in the pot pre-flop
+  T pfr; //deals in which the player bet or raised pre-flop
+  T threebets; //deals in which the player reraised pre-flop
+  T flops_seen;
+  T showdowns_seen;
+  T wins_showdown;
+  T postflop_aggression; //bets and raises after the flop
+  T postflop_calls;
+  T chips_won;
+  T chips_lost;
+
+  RecentStats()
+  : deals(0), vpip(0), pfr(0), threebets(0), flops_seen(0), showdowns_seen(0), wins_showdown(0)
+  , postflop_aggression(0), postflop_calls(0), chips_won(0), chips_lost(0)
+  {
+  }
+
+  double getVPIP() const { return ratio(vpip, deals); }
+  double getPFR() const { return ratio(pfr, deals); }
+  double get3BetPF() const { return ratio(threebets, deals); }
+  double getWSD() const { return ratio(showdowns_seen, flops_seen); }
+  double getWSDW() const { return ratio(wins_showdown, showdowns_seen); }
+  double getAF() const { return ratio(postflop_aggression, postflop_calls); }
+
+  //adds the counts of other, multiplied by factor
+  template<typename U>
+  void add(const RecentStats<U>& other, T factor)
+  {
+    deals += other.deals * factor;
+    vpip += other.vpip * factor;
+    pfr += other.pfr * factor;
+    threebets += other.threebets * factor;
+    flops_seen += other.flops_seen * factor;
+    showdowns_seen += other.showdowns_seen * factor;
+    wins_showdown += other.wins_showdown * factor;
+    postflop_aggression += other.postflop_aggression * factor;
+    postflop_calls += other.postflop_calls * factor;
+    chips_won += other.chips_won * factor;
+    chips_lost += other.chips_lost * factor;
+  }
+
+  static double ratio(T a, T b) { return b == 0 ? 0.0 : (double)a / (double)b; }
 };
 
 struct TableStats
@@ -172,6 +287,8 @@ struct TableStats
   int quits; //amount of players quitting
 
   //todo: stats about the playing style at this table
+
+  void add(const TableStats& other);
 };
 
 class StatKeeper
@@ -189,17 +306,45 @@ class StatKeeper
       bool folded; //folded during this deal
       int deal_stat; //0: first action fold / uninited, 1: check, 2: call, 3: bet, 4: raise. Used for tracking the "deal_###" stats.
       int deal_preflop_stat; //0: first action fold / uninited, 1: check, 2: call, 3: bet, 4: raise. Used for tracking the "deal_preflop_###" stats.
+      bool shown; //whether the hole cards of the player were shown at the showdown of this deal
+      Card holeCard1; //the shown hole cards
+      Card holeCard2;
+      int position; //StatPosition of the player in this deal, from the seat order at the E_DEALER event
+
+      RecentStats<int> total; //the totals of stats at the start of the deal, to get the counts of one deal from
+      std::vector<RecentStats<int> > window; //the counts of the last deals, a ring buffer of at most windowSize deals
+      size_t windowPos; //where the next deal goes in the ring, once it's full
+      RecentStats<int> windowSum; //the sum of window
+      RecentStats<double> decayed;
     };
 
-    std::map<std::string, MyPlayerInfo*> statmap;
+    std::map<std::string, MyPlayerInfo*> statmap; //by name. Only used the first time a player id is seen, and for getPlayerStats.
+    std::vector<MyPlayerInfo*> sortedPlayers; //the same players, sorted by name like the map, for the loops over all players during a deal
+    std::vector<MyPlayerInfo*> playersById; //by the player id of the events, so that most events need no lookup by name
+    const EventStrings* idStrings; //the EventStrings the ids of playersById are from, each game has its own
 
     MyPlayerInfo* getPlayerStatsInternal(const std::string& player); //this adds it to the std::map if needed
+    MyPlayerInfo* getPlayerInfo(const Event& event); //the player of the event, looked up by id
     TableStats tableStats;
 
     Round round; //round deduced from the events
 
     int highestBet; //kept track from from the events, to calculate callamount for current player from
 
+    std::vector<Card> boardCards; //board cards of this deal, from the events
+    int allinBoardSize; //how many board cards were known at the last betting action (0, 3, 4 or 5). Less than 5 at a showdown means everyone was all-in before the river
+    bool allinAdjusted; //true once the all-in equity of this deal is added to the stats
+
+    std::vector<MyPlayerInfo*> seats; //the players at the table in seat order, from the E_JOIN and E_QUIT events
+    int tableSize; //index in PlayerStats::table_sizes for this deal
+    void setPositions(const MyPlayerInfo* dealer); //gives every seated player their position in this deal
+
+    bool addAllInEquity(); //at showdown, adds the all-in equity of this deal to the stats. Returns false if it doesn't apply to this deal.
+
+    int windowSize;
+    double decay;
+    void addRecentDeals(); //adds the deal that just finished to the recent stats of its players
+
   public:
 
     StatKeeper();
@@ -208,8 +353,28 @@ class StatKeeper
     void onEvent(const Event& event);
 
     const PlayerStats* getPlayerStats(const std::string& player) const; //returns null if no stats for that player are available
+
+    /*
+    The statistics of the recent deals of a player. A deal is added to them when the next deal starts,
+    so during the decisions of a deal, they're about all the deals before it. Each deal costs the same
+    time and the memory is bounded, no matter how long the game is. Return null if no stats for that
+    player are available.
+    getWindowStats: the sum of the last windowSize deals (default 100).
+    getDecayedStats: exponentially decayed: each deal, all counts are multiplied by decay (default 0.99), then the deal is added.
+    */
+    const RecentStats<int>* getWindowStats(const std::string& player) const;
+    const RecentStats<double>* getDecayedStats(const std::string& player) const;
+    void setRecentStatsSettings(int windowSize, double decay); //clears the windows, the decayed stats keep what they have
+
     const TableStats* getTableStats() const;
     void getAllPlayers(std::vector<std::string>& players) const;
+
+    /*
+    Adds all the stats of another StatKeeper to this one, e.g. to combine the stats of many tables.
+    The players are matched by name. Only meant for combining finished games: the state of a
+    deal in progress, and the recent stats, are not taken over.
+    */
+    void add(const StatKeeper& other);
 };
 
 std::string statisticsToString(const PlayerStats& stats);
@@ -26,6 +26,9 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #include <string>
 #include <algorithm>
 #include <iostream>
+#include <cmath>
+#include <ctime>
+#include <cstdio>
 
 #include "ai.h"
 #include "ai_blindlimp.h"
@@ -36,14 +39,27 @@ along with OOPoker.  If not, see <http://www.gnu.org/licenses/>.
 #include "ai_smart.h"
 #include "card.h"
 #include "combination.h"
+#include "compress.h"
+#include "deck.h"
+#include "duplicate.h"
+#include "enumerate.h"
 #include "game.h"
+#include "handrecord.h"
+#include "host.h"
 #include "io_terminal.h"
+#include "multitable.h"
 #include "player.h"
 #include "pokereval.h"
 #include "pokermath.h"
 #include "random.h"
 #include "table.h"
 #include "info.h"
+#include "observer.h"
+#include "observer_async.h"
+#include "observer_handrecord.h"
+#include "observer_log.h"
+#include "observer_statkeeper.h"
+#include "statistics.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -344,6 +360,46 @@ void testDividePot()
 
 }
 
+void testExpectedPotDivision()
+{
+  std::cout << "Testing Expected Pot Division" << std::endl;
+
+  //aces against kings on the turn, only the two remaining kings on the river save the kings. Player 2 folded with 20 chips in the pot.
+  std::vector<int> wager; wager.push_back(100); wager.push_back(100); wager.push_back(20);
+  std::vector<bool> folded; folded.push_back(false); folded.push_back(false); folded.push_back(true);
+  std::vector<Card> holeCards;
+  holeCards.push_back(Card("As")); holeCards.push_back(Card("Ad"));
+  holeCards.push_back(Card("Kh")); holeCards.push_back(Card("Kd"));
+  holeCards.push_back(Card("Qc")); holeCards.push_back(Card("Qs"));
+  std::vector<Card> board; board.push_back(Card("2c")); board.push_back(Card("7d")); board.push_back(Card("9h")); board.push_back(Card("Tc"));
+
+  std::vector<double> wins;
+  getExpectedPotDivision(wins, wager, folded, holeCards, board);
+  std::cout << "wins: " << wins[0] << " " << wins[1] << " " << wins[2] << std::endl;
+  ASSERT_TRUE(std::fabs(wins[0] - 220.0 * 42 / 44) < 1e-9);
+  ASSERT_TRUE(std::fabs(wins[1] - 220.0 * 2 / 44) < 1e-9);
+  ASSERT_TRUE(wins[2] == 0);
+
+  //now player 2 is all-in with the queens for 50: a main pot of 150 and a side pot of 100. The queens win the main pot with the two remaining queens.
+  wager[2] = 50;
+  folded[2] = false;
+  getExpectedPotDivision(wins, wager, folded, holeCards, board);
+  std::cout << "wins: " << wins[0] << " " << wins[1] << " " << wins[2] << std::endl;
+  ASSERT_TRUE(std::fabs(wins[0] - (38.0 * 250 + 2.0 * 100) / 42) < 1e-9);
+  ASSERT_TRUE(std::fabs(wins[1] - 2.0 * 250 / 42) < 1e-9);
+  ASSERT_TRUE(std::fabs(wins[2] - 2.0 * 150 / 42) < 1e-9);
+
+  //with the complete board, it's the same as dividePot
+  board.push_back(Card("Ks"));
+  getExpectedPotDivision(wins, wager, folded, holeCards, board);
+  std::cout << "wins: " << wins[0] << " " << wins[1] << " " << wins[2] << std::endl;
+  ASSERT_TRUE(wins[0] == 0);
+  ASSERT_TRUE(wins[1] == 250);
+  ASSERT_TRUE(wins[2] == 0);
+
+  std::cout << std::endl;
+}
+
 void testBetsSettled(bool expected
                    , int lastRaiseIndex, int current, int prev_current
                    , bool a0, bool a1, bool a2, bool a3, bool a4 //is this player all-in?
@@ -485,6 +541,74 @@ void testCombosCompare()
   testCombosCompare("6s5h4c3c2sKdTd", "5h4c3c2sAh9sTd");
 }
 
+struct SubsetCounter
+{
+  int count;
+  CardMask all; //xor of all visited subsets, to check that each subset is visited exactly once
+  int k;
+
+  SubsetCounter(int k) : count(0), all(0), k(k) {}
+
+  void operator()(const int* out)
+  {
+    CardMask mask = cardsToMask(out, k);
+    all ^= mask * (count + 1);
+    count++;
+  }
+};
+
+void testEnumerateKSubsets()
+{
+  std::cout << "Testing k-subset enumeration" << std::endl;
+
+  int values[10] = {0, 3, 7, 12, 20, 21, 33, 40, 45, 51};
+  int out[7];
+
+  for(int k = 0; k <= 5; k++)
+  {
+    SubsetCounter whole(k);
+    enumerateKSubsets(k, values, 10, out, whole);
+    ASSERT_EQUALS((int)binomial(10, k), whole.count);
+
+    //the parts together must visit the same subsets in the same order as the whole
+    SubsetCounter parts(k);
+    for(int part = 0; part < 3; part++) enumerateKSubsets(k, values, 10, out, parts, part, 3);
+    ASSERT_EQUALS(whole.count, parts.count);
+    ASSERT_TRUE(whole.all == parts.all);
+  }
+
+  SubsetCounter fromMask(2);
+  enumerateKSubsets(2, CARDMASK_ALL & ~cardToMask(0) & ~cardToMask(51), out, fromMask);
+  ASSERT_EQUALS(1225, fromMask.count); //50 choose 2
+
+  std::cout << std::endl;
+}
+
+void testWinChanceWithKnownHands()
+{
+  std::cout << "Testing win chance with known hands" << std::endl;
+
+  std::vector<Card> holeCards1, holeCards2, boardCards;
+  holeCards1.push_back(Card("As")); holeCards2.push_back(Card("Ah"));
+  holeCards1.push_back(Card("Ks")); holeCards2.push_back(Card("Kh"));
+  boardCards.push_back(Card("2c"));
+  boardCards.push_back(Card("7d"));
+  boardCards.push_back(Card("9h"));
+  boardCards.push_back(Card("Tc"));
+
+  std::vector<double> win, tie, lose;
+  ASSERT_TRUE(getWinChanceWithKnownHands(win, tie, lose, holeCards1, holeCards2, boardCards));
+
+  //44 possible river cards, the kings win with the 2 remaining kings only
+  std::cout << "aces: " << win[0] << " " << tie[0] << " " << lose[0] << std::endl;
+  std::cout << "kings: " << win[1] << " " << tie[1] << " " << lose[1] << std::endl;
+  ASSERT_TRUE(std::abs(win[0] - 42.0 / 44.0) < 1e-9);
+  ASSERT_TRUE(std::abs(lose[0] - 2.0 / 44.0) < 1e-9);
+  ASSERT_TRUE(std::abs(win[1] - 2.0 / 44.0) < 1e-9);
+
+  std::cout << std::endl;
+}
+
 void testRandom()
 {
   for(size_t i = 0; i < 50; i++) std::cout << getRandom() << " ";
@@ -497,11 +621,190 @@ void testRandom()
   std::cout << std::endl;
 }
 
+void testChaCha20()
+{
+  std::cout << "Testing ChaCha20" << std::endl;
+
+  //test vector of RFC 8439, section 2.3.2
+  uint32_t in[16] = { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+                      0x03020100, 0x07060504, 0x0b0a0908, 0x0f0e0d0c, 0x13121110, 0x17161514, 0x1b1a1918, 0x1f1e1d1c,
+                      0x00000001, 0x09000000, 0x4a000000, 0x00000000 };
+  uint32_t expected[16] = { 0xe4e7f110, 0x15593bd1, 0x1fdd0f50, 0xc47120a3, 0xc7f4d1c7, 0x0368c033, 0x9aaa2204, 0x4e6cd4c3,
+                            0x466482d2, 0x09aa9f07, 0x05d7c214, 0xa2028bd9, 0xd19c12b5, 0xb94e16de, 0xe883d0cb, 0x4e3c50a2 };
+  uint32_t out[16];
+  chacha20Block(out, in);
+  for(int i = 0; i < 16; i++) ASSERT_EQUALS(expected[i], out[i]);
+
+  //the buffered generator should be fast enough to use for every random number
+  static const int numSamples = 10000000;
+  std::clock_t start = std::clock();
+  unsigned int test = 0;
+  for(int i = 0; i < numSamples; i++) test ^= getRandomUint();
+  double seconds = (double)(std::clock() - start) / CLOCKS_PER_SEC;
+  std::cout << numSamples << " random numbers in " << seconds << " seconds (" << (test & 1) << ")" << std::endl;
+
+  std::cout << std::endl;
+}
+
+void testRandomBounded()
+{
+  std::cout << "Testing bounded random" << std::endl;
+
+  RandomFast random;
+
+  //with a range of 3 * 2^30, modulo gives values below 2^30 twice as often as the others, so half of all values instead of a third
+  static const int numSamples = 1000000;
+  unsigned int range = 3u << 30;
+  int lowBounded = 0;
+  int lowModulo = 0;
+  for(int i = 0; i < numSamples; i++)
+  {
+    if(getRandomBounded(random, range) < (1u << 30)) lowBounded++;
+    if(random.getUint() % range < (1u << 30)) lowModulo++;
+  }
+  double fractionBounded = (double)lowBounded / numSamples;
+  double fractionModulo = (double)lowModulo / numSamples;
+  std::cout << "fraction of low values, bounded: " << fractionBounded << ", modulo: " << fractionModulo << " (unbiased: 0.333333)" << std::endl;
+  ASSERT_TRUE(std::abs(fractionBounded - 1.0 / 3.0) < 0.005);
+
+  for(int i = 0; i < 1000; i++)
+  {
+    int r = getRandomFast(3, 7);
+    ASSERT_TRUE(r >= 3 && r <= 7);
+  }
+
+  //draws per second, for the range sizes of dealing cards
+  static const int numDraws = 50000000;
+  unsigned int test = 0;
+  std::clock_t start = std::clock();
+  for(int i = 0; i < numDraws; i++) test += random.getUint() % (52 - (i & 31));
+  double secondsModulo = (double)(std::clock() - start) / CLOCKS_PER_SEC;
+  start = std::clock();
+  for(int i = 0; i < numDraws; i++) test += getRandomBounded(random, 52 - (i & 31));
+  double secondsBounded = (double)(std::clock() - start) / CLOCKS_PER_SEC;
+  std::cout << "draws per second, modulo: " << numDraws / secondsModulo << ", bounded: " << numDraws / secondsBounded << " (" << (test & 1) << ")" << std::endl;
+
+  std::cout << std::endl;
+}
+
+void testRandomLanes()
+{
+  std::cout << "Testing random lanes" << std::endl;
+
+  //same seed gives the same values, also when filled in parts that aren't a multiple of the amount of lanes
+  RandomLanes a(5), b(5);
+  uint32_t va[100], vb[100];
+  a.fill(va, 100);
+  b.fill(vb, 37);
+  b.fill(vb + 37, 63);
+  for(int i = 0; i < 37; i++) ASSERT_EQUALS(va[i], vb[i]);
+  ASSERT_TRUE(va[40] != vb[40]); //the values after the 37 continue from the next step instead
+
+  //a jumped generator gives other values
+  RandomLanes c(5);
+  c.jump();
+  c.fill(vb, 100);
+  int same = 0;
+  for(int i = 0; i < 100; i++) if(va[i] == vb[i]) same++;
+  ASSERT_TRUE(same < 3);
+
+  //bounded values are in range and about uniform
+  static const int numSamples = 52000;
+  std::vector<uint32_t> values(numSamples);
+  a.fillBounded(&values[0], numSamples, 52);
+  int counts[52] = { 0 };
+  for(int i = 0; i < numSamples; i++)
+  {
+    ASSERT_TRUE(values[i] < 52);
+    counts[values[i]]++;
+  }
+  for(int i = 0; i < 52; i++) ASSERT_TRUE(counts[i] > 800 && counts[i] < 1200);
+
+  static const int numValues = 100000000;
+  static const int bufferSize = 4096;
+  uint32_t buffer[bufferSize];
+  unsigned int test = 0;
+  std::clock_t start = std::clock();
+  for(int i = 0; i < numValues; i += bufferSize)
+  {
+    a.fill(buffer, bufferSize);
+    test += buffer[i & (bufferSize - 1)];
+  }
+  double secondsLanes = (double)(std::clock() - start) / CLOCKS_PER_SEC;
+  start = std::clock();
+  for(int i = 0; i < numValues; i++) test += getRandomUintFast();
+  double secondsFast = (double)(std::clock() - start) / CLOCKS_PER_SEC;
+  std::cout << "random values per second, lanes: " << numValues / secondsLanes << ", getRandomUintFast: " << numValues / secondsFast << " (" << (test & 1) << ")" << std::endl;
+
+  std::cout << std::endl;
+}
+
+void testDeck()
+{
+  std::cout << "Testing deck" << std::endl;
+
+  Deck deck;
+  ASSERT_TRUE(deck.remove(Card("As")));
+  ASSERT_TRUE(deck.remove(Card("Kd")));
+  ASSERT_TRUE(!deck.remove(Card("As")));
+  ASSERT_EQUALS(50, deck.getNumLeft());
+
+  for(int k = 0; k < 3; k++) //the removed cards stay out after shuffling
+  {
+    deck.shuffle();
+    bool seen[52] = { false };
+    for(int i = 0; i < 50; i++)
+    {
+      Card card = deck.next();
+      ASSERT_TRUE(card.isValid());
+      ASSERT_TRUE(!seen[card.getIndex()]);
+      seen[card.getIndex()] = true;
+    }
+    ASSERT_TRUE(!deck.next().isValid());
+    ASSERT_TRUE(!seen[Card("As").getIndex()]);
+    ASSERT_TRUE(!seen[Card("Kd").getIndex()]);
+  }
+
+  //replaying a recorded order
+  int order[52];
+  deck.getOrder(order);
+  Deck replay;
+  replay.setOrder(order);
+  for(int i = 0; i < 50; i++) ASSERT_EQUALS(order[i], replay.next().getIndex());
+
+  //the same random numbers give the same cards, no matter how many cards were dealt before the shuffle
+  {
+    Deck lazy;
+    int first[5];
+    RandomStream stream(1, 2);
+    for(int i = 0; i < 5; i++) first[i] = lazy.nextIndex(stream);
+    lazy.shuffle();
+    for(int i = 0; i < 30; i++) lazy.next();
+    lazy.shuffle();
+    stream.seed(1, 2);
+    for(int i = 0; i < 5; i++) ASSERT_EQUALS(first[i], lazy.nextIndex(stream));
+  }
+
+  //every card should be about equally likely to be dealt first
+  static const int numSamples = 52000;
+  int counts[52] = { 0 };
+  Deck full;
+  RandomFast random;
+  for(int i = 0; i < numSamples; i++)
+  {
+    full.shuffle();
+    counts[full.nextIndex(random)]++;
+  }
+  for(int i = 0; i < 52; i++) ASSERT_TRUE(counts[i] > 800 && counts[i] < 1200);
+
+  std::cout << std::endl;
+}
+
 static void shuffleN(int* values, int size, int amount)
 {
   for(int i = 0; i < amount; i++)
   {
-    int r = getRandomFast(0, size - 1);
+    int r = getRandomFast(i, size - 1); //from the cards not chosen yet, otherwise the result is biased
     std::swap(values[i], values[r]);
   }
 }
@@ -543,6 +846,1084 @@ void benchmarkEval7()
   //std::cout << "end time: " << getDateString() << std::endl;
 }
 
+/*
+Compares the error of the sampling methods against the exact win chance from the against 1
+function, for several amounts of samples. For the same error, SM_STRATIFIED should need
+several times less samples (and thus eval7 calls) than SM_MONTE_CARLO. SM_BATCHED should
+have the same error as SM_MONTE_CARLO.
+*/
+void benchmarkWinChanceSampling(const std::string& hcard1, const std::string& hcard2, const std::string& card1, const std::string& card2, const std::string& card3)
+{
+  std::cout << "Benchmarking sampling error at flop (" << hcard1 << " " << hcard2 << " | " << card1 << " " << card2 << " " << card3 << ")" << std::endl;
+
+  double exactWin, exactTie, exactLose;
+  getWinChanceAgainst1AtFlop(exactWin, exactTie, exactLose, Card(hcard1), Card(hcard2), Card(card1), Card(card2), Card(card3));
+
+  static const int numTrials = 20;
+  static const int numSamples[4] = { 1000, 4000, 16000, 64000 };
+  static const SampleMethod methods[3] = { SM_MONTE_CARLO, SM_STRATIFIED, SM_BATCHED };
+  static const char* names[3] = { "monte carlo", "stratified", "batched" };
+
+  double rms[3][4];
+
+  for(int m = 0; m < 3; m++)
+  for(int n = 0; n < 4; n++)
+  {
+    double sum = 0;
+    for(int t = 0; t < numTrials; t++)
+    {
+      double win, tie, lose;
+      getWinChanceAgainstNAtFlop(win, tie, lose, Card(hcard1), Card(hcard2), Card(card1), Card(card2), Card(card3), 1, numSamples[n], methods[m]);
+      sum += (win - exactWin) * (win - exactWin);
+    }
+    rms[m][n] = std::sqrt(sum / numTrials);
+    std::cout << names[m] << ", samples: " << numSamples[n] << ", rms error of win chance: " << rms[m][n] << std::endl;
+  }
+
+  //with plenty of samples, both must be close to the exact result
+  ASSERT_TRUE(rms[0][3] < 0.01);
+  ASSERT_TRUE(rms[1][3] < 0.01);
+  ASSERT_TRUE(rms[2][3] < 0.01);
+
+  std::cout << std::endl;
+}
+
+void benchmarkWinChanceSampling()
+{
+  benchmarkWinChanceSampling("6d", "2d", "8d", "Td", "Jh"); //flush draw, the river decides a lot
+  benchmarkWinChanceSampling("Ah", "Kd", "8s", "7s", "Jh");
+}
+
+//Compares the speed of the monte carlo sampling with and without batching.
+void benchmarkWinChanceBatched()
+{
+  static const int numSamples = 1000000;
+  static const int opponents[3] = { 1, 5, 9 };
+
+  std::cout << "Benchmarking batched win chance at flop with " << numSamples << " samples" << std::endl;
+
+  for(int o = 0; o < 3; o++)
+  {
+    double seconds[2];
+    for(int m = 0; m < 2; m++)
+    {
+      double win, tie, lose;
+      std::clock_t start = std::clock();
+      getWinChanceAgainstNAtFlop(win, tie, lose, Card("Ah"), Card("Kd"), Card("8s"), Card("7s"), Card("Jh"), opponents[o], numSamples, m == 0 ? SM_MONTE_CARLO : SM_BATCHED);
+      seconds[m] = (double)(std::clock() - start) / CLOCKS_PER_SEC;
+    }
+    std::cout << "opponents: " << opponents[o] << ", monte carlo: " << seconds[0] << "s, batched: " << seconds[1] << "s" << std::endl;
+  }
+
+  std::cout << std::endl;
+}
+
+void testEquityCache()
+{
+  std::cout << "Testing equity cache" << std::endl;
+
+  clearEquityCache();
+
+  std::vector<Card> hole1; hole1.push_back(Card("Ah")); hole1.push_back(Card("Kh"));
+  std::vector<Card> board1; board1.push_back(Card("2h")); board1.push_back(Card("7c")); board1.push_back(Card("9d"));
+  //the same, with other suits and in another order
+  std::vector<Card> hole2; hole2.push_back(Card("Ks")); hole2.push_back(Card("As"));
+  std::vector<Card> board2; board2.push_back(Card("9c")); board2.push_back(Card("2s")); board2.push_back(Card("7d"));
+  //not the same: the deuce doesn't have the suit of the hole cards
+  std::vector<Card> board3; board3.push_back(Card("2c")); board3.push_back(Card("7h")); board3.push_back(Card("9d"));
+
+  double win1, tie1, lose1, win2, tie2, lose2;
+  getWinChanceAgainstNCached(win1, tie1, lose1, hole1, board1, 3, 1000);
+  getWinChanceAgainstNCached(win2, tie2, lose2, hole2, board2, 3, 1000);
+  ASSERT_EQUALS(win1, win2);
+  ASSERT_EQUALS(tie1, tie2);
+  ASSERT_EQUALS(1u, getEquityCacheStats().hits);
+  ASSERT_EQUALS(1u, getEquityCacheStats().misses);
+
+  getWinChanceAgainstNCached(win2, tie2, lose2, hole1, board3, 3, 1000);
+  getWinChanceAgainstNCached(win2, tie2, lose2, hole1, board1, 4, 1000);
+  getPotEquityCached(hole1, board1, 3, 1000);
+  ASSERT_EQUALS(1u, getEquityCacheStats().hits);
+  ASSERT_EQUALS(4u, getEquityCacheStats().misses);
+  ASSERT_EQUALS(4u, getEquityCacheStats().size);
+
+  //the least recently used ones are forgotten
+  setEquityCacheCapacity(2);
+  ASSERT_EQUALS(2u, getEquityCacheStats().size);
+  getPotEquityCached(hole2, board2, 3, 1000);
+  ASSERT_EQUALS(2u, getEquityCacheStats().hits);
+  getWinChanceAgainstNCached(win2, tie2, lose2, hole2, board2, 3, 1000);
+  ASSERT_EQUALS(5u, getEquityCacheStats().misses);
+
+  setEquityCacheCapacity(4096);
+  clearEquityCache();
+  ASSERT_EQUALS(0u, getEquityCacheStats().size);
+
+  std::cout << std::endl;
+}
+
+//host that never quits, for running games in the unit test
+class HostUnitTest : public Host
+{
+  public:
+    virtual void onFrame() {}
+    virtual void onGameBegin(const Info& info) { (void)info; }
+    virtual void onDealDone(const Info& info) { (void)info; }
+    virtual void onGameDone(const Info& info) { (void)info; }
+    virtual bool wantToQuit() const { return false; }
+    virtual void resetWantToQuit() {}
+};
+
+//appends all events to a string
+class ObserverEventString : public Observer
+{
+  private:
+    std::string& result;
+
+  public:
+    ObserverEventString(std::string& result) : result(result) {}
+    virtual void onEvent(const Event& event) { result += eventToString(event) + "\n"; }
+};
+
+static std::string runSeededGame(uint64_t seed, const std::string& recordFile, const std::string& replayFile, const std::string& journalFile = "", bool async = false)
+{
+  std::string result;
+  HostUnitTest host;
+  Game game(&host);
+
+  Rules rules;
+  rules.buyIn = 1000;
+  rules.smallBlind = 10;
+  rules.bigBlind = 20;
+  rules.allowRebuy = true;
+  rules.fixedNumberOfDeals = 50;
+  game.setRules(rules);
+
+  game.setSeed(seed);
+  if(!recordFile.empty()) ASSERT_TRUE(game.recordDecks(recordFile));
+  if(!replayFile.empty()) ASSERT_TRUE(game.replayDecks(replayFile));
+  if(!journalFile.empty()) ASSERT_TRUE(game.journalEvents(journalFile));
+
+  game.addPlayer(Player(new AISmart(), "smart1"));
+  game.addPlayer(Player(new AISmart(), "smart2"));
+  game.addPlayer(Player(new AIRandom(), "random"));
+  game.addPlayer(Player(new AICall(), "call"));
+  if(async) game.addObserver(new ObserverAsync(new ObserverEventString(result), 16)); //small ring, so that the game often has to wait
+  else game.addObserver(new ObserverEventString(result));
+
+  game.doGame();
+  return result;
+}
+
+void testSeededGame()
+{
+  std::cout << "Testing seeded game" << std::endl;
+
+  std::string a = runSeededGame(12345, "unittest_decks.bin", "");
+  std::string b = runSeededGame(12345, "", "");
+  std::string c = runSeededGame(12345, "", "unittest_decks.bin");
+  std::string d = runSeededGame(54321, "", "");
+  std::remove("unittest_decks.bin");
+
+  ASSERT_TRUE(a == b);
+  ASSERT_TRUE(a == c);
+  ASSERT_TRUE(a != d);
+
+  std::cout << std::endl;
+}
+
+//check-folds, and appends the hole cards it gets to a string, and the board cards to another one
+class AIRecordCards : public AICheckFold
+{
+  public:
+    std::string& cards;
+    std::string& board;
+    AIRecordCards(std::string& cards, std::string& board) : cards(cards), board(board) {}
+    virtual void onEvent(const Event& event)
+    {
+      if(event.type == E_RECEIVE_CARDS) cards += event.card1.getShortName() + event.card2.getShortName() + " ";
+      else if(event.type == E_FLOP) board += event.card1.getShortName() + event.card2.getShortName() + event.card3.getShortName() + " ";
+      else if(event.type == E_TURN) board += event.card4.getShortName() + " ";
+      else board += event.card5.getShortName() + " ";
+    }
+    virtual EventMask getEventMask() const { return eventMask(E_RECEIVE_CARDS) | eventMask(E_FLOP) | eventMask(E_TURN) | eventMask(E_RIVER); }
+};
+
+//the hole cards two seats get in a seeded game, where the first seat is played by the given AI. board, if not null, gets the board cards they saw.
+static std::string runSeededCards(AI* first, const std::string& recordFile, const std::string& replayFile, std::string* board = 0)
+{
+  std::string result;
+  std::string boardCards;
+  HostUnitTest host;
+  Game game(&host);
+
+  Rules rules;
+  rules.buyIn = 1000;
+  rules.smallBlind = 10;
+  rules.bigBlind = 20;
+  rules.allowRebuy = true;
+  rules.fixedNumberOfDeals = 20;
+  game.setRules(rules);
+
+  game.setSeed(777);
+  if(!recordFile.empty()) ASSERT_TRUE(game.recordDecks(recordFile));
+  if(!replayFile.empty()) ASSERT_TRUE(game.replayDecks(replayFile));
+
+  game.addPlayer(Player(first, "first"));
+  game.addPlayer(Player(new AIRecordCards(result, boardCards), "record1"));
+  game.addPlayer(Player(new AIRecordCards(result, boardCards), "record2"));
+  game.addPlayer(Player(new AIRaise(), "raise"));
+
+  game.doGame();
+  if(board) *board = boardCards;
+  return result;
+}
+
+void testSeededCards()
+{
+  std::cout << "Testing seeded cards with different AI's" << std::endl;
+
+  //with AICall the deals go on to the river, with AICheckFold everyone folds to the raise before the flop. The cards of the seats must still be the same.
+  std::string boardA, boardD;
+  std::string a = runSeededCards(new AICall(), "unittest_decks.bin", "", &boardA);
+  std::string b = runSeededCards(new AICheckFold(), "", "");
+  std::string c = runSeededCards(new AICheckFold(), "", "unittest_decks.bin");
+  std::string d = runSeededCards(new AICheckFold(), "unittest_decks2.bin", "");
+  std::string e = runSeededCards(new AICall(), "", "unittest_decks2.bin", &boardD); //the recording must also have the cards of the rounds its own deals didn't reach
+  std::remove("unittest_decks.bin");
+  std::remove("unittest_decks2.bin");
+
+  ASSERT_EQUALS(20u * 2u * 5u, a.size());
+  ASSERT_EQUALS(a, b);
+  ASSERT_EQUALS(a, c);
+  ASSERT_EQUALS(a, d);
+  ASSERT_EQUALS(a, e);
+  ASSERT_TRUE(boardA.size() > 100);
+  ASSERT_EQUALS(boardA, boardD);
+
+  std::cout << std::endl;
+}
+
+void testEventJournal()
+{
+  std::cout << "Testing event journal" << std::endl;
+
+  std::string a = runSeededGame(777, "", "", "unittest_events.bin");
+
+  //the journal must give exactly the same events as the observers got
+  std::string b;
+  EventJournalReader reader("unittest_events.bin");
+  ASSERT_TRUE(reader.isOpen());
+  Event event(E_NUM_EVENTS);
+  int num = 0;
+  while(reader.read(event))
+  {
+    b += eventToString(event) + "\n";
+    num++;
+  }
+  std::remove("unittest_events.bin");
+
+  std::cout << "events: " << num << ", bytes of text: " << b.size() << std::endl;
+  ASSERT_TRUE(num > 50);
+  ASSERT_TRUE(a == b);
+
+  std::cout << std::endl;
+}
+
+void testObserverAsync()
+{
+  std::cout << "Testing async observer" << std::endl;
+
+  //the game flushes at the end, so the result is complete after the game, with all messages and names
+  std::string a = runSeededGame(4321, "", "", "", false);
+  std::string b = runSeededGame(4321, "", "", "", true);
+  ASSERT_TRUE(a.size() > 1000);
+  ASSERT_TRUE(a == b);
+
+  std::cout << std::endl;
+}
+
+void testCompress()
+{
+  std::cout << "Testing compression" << std::endl;
+
+  std::vector<std::string> inputs;
+  inputs.push_back("");
+  inputs.push_back("a");
+  inputs.push_back(std::string(100000, 'x')); //long matches that overlap themselves
+  std::string random;
+  for(int i = 0; i < 5000; i++) random += (char)getRandom(0, 255); //not compressible
+  inputs.push_back(random);
+  inputs.push_back(runSeededGame(99, "", ""));
+
+  for(size_t i = 0; i < inputs.size(); i++)
+  {
+    const std::string& in = inputs[i];
+    std::vector<unsigned char> packed;
+    size_t size = compressBlock(packed, (const unsigned char*)in.data(), in.size());
+    ASSERT_EQUALS(packed.size(), size);
+    ASSERT_TRUE(size <= compressBound(in.size()));
+    std::string out(in.size(), ' ');
+    ASSERT_TRUE(decompressBlock((unsigned char*)&out[0], out.size(), packed.empty() ? 0 : &packed[0], packed.size()));
+    ASSERT_TRUE(in == out);
+    if(i == 4) std::cout << "log text: " << in.size() << " bytes, compressed: " << size << " bytes" << std::endl;
+
+    //corrupt data must be detected, and never write outside the buffer
+    if(size > 4)
+    {
+      ASSERT_TRUE(!decompressBlock((unsigned char*)&out[0], out.size(), &packed[0], size - 3) || in.size() < 4);
+      ASSERT_TRUE(!decompressBlock((unsigned char*)&out[0], out.size() - 1, &packed[0], size));
+    }
+  }
+
+  std::cout << std::endl;
+}
+
+//gives the events of the journal to the log, and returns the text the log got
+static std::string writeJournalToLog(const std::string& journalFile, const std::string& logFile, const LogSettings& settings)
+{
+  std::string result;
+  ObserverLog log(logFile, settings);
+  EventJournalReader reader(journalFile);
+  Event event(E_NUM_EVENTS);
+  while(reader.read(event))
+  {
+    log.onEvent(event);
+    result += eventToString(event) + "\n";
+  }
+  return result;
+}
+
+//reads all files of a rotated log and removes them
+static std::string readAndRemoveLog(const std::string& logFile, int& numFiles)
+{
+  std::string result;
+  for(numFiles = 0; readLogFile(result, getLogFileName(logFile, numFiles)); numFiles++)
+  {
+    std::remove(getLogFileName(logFile, numFiles).c_str());
+  }
+  return result;
+}
+
+void testObserverLog()
+{
+  std::cout << "Testing log" << std::endl;
+
+  runSeededGame(555, "", "", "unittest_events.bin");
+
+  LogSettings plain;
+  LogSettings packed;
+  packed.compress = true;
+  packed.blockSize = 1000;
+  packed.rotateSize = 10000;
+
+  int numFiles = 0;
+  std::string a = writeJournalToLog("unittest_events.bin", "unittest_log.txt", plain);
+  std::string b = readAndRemoveLog("unittest_log.txt", numFiles);
+  ASSERT_EQUALS(1, numFiles);
+  ASSERT_TRUE(a.size() > 1000);
+  ASSERT_TRUE(b.find("OOPoker Log") != std::string::npos);
+  ASSERT_TRUE(b.size() > a.size() && b.substr(b.size() - a.size()) == a); //after the title and date
+
+  std::string c = writeJournalToLog("unittest_events.bin", "unittest_log.txz", packed);
+  std::string d = readAndRemoveLog("unittest_log.txz", numFiles);
+  std::cout << "rotated compressed log files: " << numFiles << std::endl;
+  ASSERT_TRUE(numFiles > 1);
+  ASSERT_TRUE(d.size() > c.size() && d.substr(d.size() - c.size()) == c);
+
+  //a second run of a rotated log continues after the last file, the runs must not get mixed
+  writeJournalToLog("unittest_events.bin", "unittest_log.txz", packed);
+  writeJournalToLog("unittest_events.bin", "unittest_log.txz", packed);
+  std::string e = readAndRemoveLog("unittest_log.txz", numFiles);
+  ASSERT_EQUALS(2 * d.size(), e.size());
+  ASSERT_TRUE(e.substr(d.size() - c.size(), c.size()) == c);
+  ASSERT_TRUE(e.substr(e.size() - c.size()) == c);
+
+  //a compressed log isn't appended to a plain one, or the other way around, it goes to the next file
+  writeJournalToLog("unittest_events.bin", "unittest_log.txt", plain);
+  writeJournalToLog("unittest_events.bin", "unittest_log.txt", packed);
+  writeJournalToLog("unittest_events.bin", "unittest_log.txt", plain);
+  std::string f = readAndRemoveLog("unittest_log.txt", numFiles);
+  std::cout << "mixed log files: " << numFiles << std::endl;
+  ASSERT_TRUE(numFiles > 2);
+  ASSERT_EQUALS(2 * b.size() + d.size(), f.size());
+  ASSERT_TRUE(f.substr(b.size() - a.size(), a.size()) == a);
+  ASSERT_TRUE(f.substr(f.size() - a.size()) == a);
+  std::remove("unittest_events.bin");
+
+  std::cout << std::endl;
+}
+
+void testEventParser()
+{
+  std::cout << "Testing event parser" << std::endl;
+
+  //every line of a log must give an event that is written the same way again
+  std::string log = runSeededGame(2468, "", "");
+  EventParser parser;
+  Event event(E_NUM_EVENTS);
+  size_t pos = 0;
+  int num = 0;
+  while(pos < log.size())
+  {
+    size_t end = log.find('\n', pos);
+    std::string line = log.substr(pos, end - pos);
+    pos = end + 1;
+    if(line.empty()) continue; //messages with multiple lines, such as the statistics at the end, can have empty lines
+    ASSERT_TRUE(parser.parse(event, line));
+    ASSERT_EQUALS(line, eventToString(event));
+    num++;
+  }
+  std::cout << "lines: " << num << std::endl;
+  ASSERT_TRUE(num > 100);
+
+  ASSERT_TRUE(!parser.parse(event, std::string("")));
+  ASSERT_TRUE(!parser.parse(event, std::string("======================OOPoker Log=======================")));
+  ASSERT_TRUE(parser.parse(event, std::string("Raises: a, b, chips: 25\r"))); //names can have commas, and the log can have windows newlines
+  ASSERT_EQUALS(E_RAISE, event.type);
+  ASSERT_EQUALS(std::string("a, b"), event.getPlayer());
+  ASSERT_EQUALS(25, event.chips);
+  ASSERT_TRUE(parser.parse(event, std::string("Flop: Ah Kd")));
+  ASSERT_EQUALS(E_LOG_MESSAGE, event.type); //not a valid flop, so it must be a message
+  ASSERT_EQUALS(std::string("Flop: Ah Kd"), event.getMessage());
+
+  //the statistics from a log must be the same as the statistics of the game itself
+  LogSettings settings;
+  settings.compress = true;
+  settings.blockSize = 1000; //lines continue in the next block
+  settings.rotateSize = 50000; //and in the next file
+  std::string live;
+  {
+    HostUnitTest host;
+    Game game(&host);
+    Rules rules;
+    rules.buyIn = 1000;
+    rules.smallBlind = 10;
+    rules.bigBlind = 20;
+    rules.allowRebuy = true;
+    rules.fixedNumberOfDeals = 2000;
+    game.setRules(rules);
+    game.setSeed(9);
+    game.addPlayer(Player(new AICall(), "call"));
+    game.addPlayer(Player(new AIRaise(), "raise"));
+    game.addPlayer(Player(new AIRandom(), "random"));
+    game.addPlayer(Player(new AIBlindLimp(), "blindlimp"));
+    game.addObserver(new ObserverLog("unittest_replay.txz", settings));
+    ObserverStatKeeper* keeper = new ObserverStatKeeper();
+    game.addObserver(keeper);
+    game.doGame();
+    live = statisticsToString(keeper->getStatKeeper());
+  }
+
+  std::vector<std::string> files;
+  std::string text;
+  while(readLogFile(text, getLogFileName("unittest_replay.txz", files.size()))) files.push_back(getLogFileName("unittest_replay.txz", files.size()));
+  std::cout << "log files: " << files.size() << std::endl;
+  ASSERT_TRUE(files.size() > 1);
+
+  ObserverStatKeeper replayed;
+  long long bytes = 0;
+  ASSERT_TRUE(replayLogFiles(files, replayed, &bytes));
+  ASSERT_EQUALS((long long)text.size(), bytes);
+  ASSERT_TRUE(live.size() > 100);
+  ASSERT_EQUALS(live, statisticsToString(replayed.getStatKeeper()));
+
+  for(size_t i = 0; i < files.size(); i++) std::remove(files[i].c_str());
+
+  std::cout << std::endl;
+}
+
+static AI* createAICall() { return new AICall(); }
+static AI* createAIRaise() { return new AIRaise(); }
+static AI* createAICheckFold() { return new AICheckFold(); }
+static AI* createAIRandom() { return new AIRandom(); }
+
+void testDuplicate()
+{
+  std::cout << "Testing duplicate poker" << std::endl;
+
+  HostUnitTest host;
+  Rules rules;
+  rules.buyIn = 1000;
+  rules.smallBlind = 10;
+  rules.bigBlind = 20;
+  rules.fixedNumberOfDeals = 50;
+
+  //two identical AI's that don't use randomness: every seat's result is played by both, so both end at exactly 0
+  std::vector<DuplicateEntrant> entrants;
+  entrants.push_back(DuplicateEntrant("call1", createAICall));
+  entrants.push_back(DuplicateEntrant("call2", createAICall));
+  std::vector<DuplicateResult> results;
+  runDuplicate(results, entrants, rules, 3, 1, &host);
+  std::cout << duplicateResultsToString(results);
+  ASSERT_EQUALS(2u, results.size());
+  ASSERT_EQUALS(6, results[0].games);
+  ASSERT_EQUALS(300, results[0].deals);
+  ASSERT_EQUALS(0, results[0].score);
+  ASSERT_EQUALS(0, results[1].score);
+
+  entrants[0] = DuplicateEntrant("checkfold", createAICheckFold);
+  entrants[1] = DuplicateEntrant("raise", createAIRaise);
+  runDuplicate(results, entrants, rules, 3, 1, &host);
+  std::cout << duplicateResultsToString(results);
+  ASSERT_EQUALS(0, results[0].score + results[1].score);
+  ASSERT_TRUE(results[1].score > 0);
+  ASSERT_EQUALS(std::string("Raise"), results[1].ai);
+
+  std::cout << std::endl;
+}
+
+void testMultiTable()
+{
+  std::cout << "Testing multi-table runner" << std::endl;
+
+  Rules rules;
+  rules.buyIn = 1000;
+  rules.smallBlind = 10;
+  rules.bigBlind = 20;
+  rules.allowRebuy = true;
+  rules.fixedNumberOfDeals = 50;
+
+  std::vector<DuplicateEntrant> entrants;
+  entrants.push_back(DuplicateEntrant("call", createAICall));
+  entrants.push_back(DuplicateEntrant("raise", createAIRaise));
+  entrants.push_back(DuplicateEntrant("random", createAIRandom));
+
+  std::vector<MultiTableResult> results1, results3;
+  MultiTableTotals totals1, totals3;
+  StatKeeper stats1, stats3;
+  runMultiTable(results1, totals1, &stats1, entrants, rules, 6, 1, 5);
+  runMultiTable(results3, totals3, &stats3, entrants, rules, 6, 3, 5);
+  std::cout << multiTableResultsToString(results3, totals3);
+
+  ASSERT_EQUALS(3u, results3.size());
+  ASSERT_EQUALS(300LL, totals3.deals);
+  ASSERT_EQUALS(3, totals3.threads);
+  ASSERT_EQUALS(0LL, results3[0].score + results3[1].score + results3[2].score);
+  ASSERT_EQUALS(6 * (1 + 2 + 3), results3[0].positionSum + results3[1].positionSum + results3[2].positionSum);
+  ASSERT_EQUALS(300, stats3.getPlayerStats("raise")->deals);
+
+  //each table has its own seed, so the amount of threads doesn't change the results
+  ASSERT_EQUALS(totals1.decisions, totals3.decisions);
+  for(size_t i = 0; i < results1.size(); i++)
+  {
+    ASSERT_EQUALS(results1[i].score, results3[i].score);
+    ASSERT_EQUALS(results1[i].positionSum, results3[i].positionSum);
+    ASSERT_EQUALS(stats1.getPlayerStats(results1[i].name)->actions, stats3.getPlayerStats(results3[i].name)->actions);
+  }
+
+  std::cout << std::endl;
+}
+
+void testHandRecord()
+{
+  std::cout << "Testing hand records" << std::endl;
+
+  StatKeeper stats;
+  {
+    HostUnitTest host;
+    Game game(&host);
+    Rules rules;
+    rules.buyIn = 1000;
+    rules.smallBlind = 10;
+    rules.bigBlind = 20;
+    rules.allowRebuy = true;
+    rules.fixedNumberOfDeals = 5000; //more than one block
+    game.setRules(rules);
+    game.setSeed(8);
+    game.addPlayer(Player(new AICall(), "call"));
+    game.addPlayer(Player(new AIRaise(), "raise"));
+    game.addPlayer(Player(new AIRandom(), "random"));
+    game.addPlayer(Player(new AIBlindLimp(), "blindlimp"));
+    ObserverHandRecord* hands = new ObserverHandRecord("unittest_hands.bin");
+    ASSERT_TRUE(hands->isOpen());
+    game.addObserver(hands);
+    ObserverStatKeeper* keeper = new ObserverStatKeeper();
+    game.addObserver(keeper);
+    game.doGame();
+    stats.add(keeper->getStatKeeper());
+  } //the game deletes the observers, that completes the file
+
+  HandRecordFile file;
+  ASSERT_TRUE(file.open("unittest_hands.bin"));
+  ASSERT_EQUALS(5000u, file.getNumRecords());
+  ASSERT_EQUALS(2u, file.getNumBlocks());
+
+  std::vector<HandRecordStats> result;
+  queryHandRecords(result, file, HandRecordFilter());
+  std::cout << handRecordStatsToString(result);
+  ASSERT_EQUALS(4u, result.size());
+
+  //the records must give the same statistics as the StatKeeper
+  for(size_t i = 0; i < result.size(); i++)
+  {
+    const HandRecordStats& h = result[i];
+    const PlayerStats* p = stats.getPlayerStats(h.name);
+    ASSERT_TRUE(p != 0);
+    if(!p) continue;
+    ASSERT_EQUALS(p->deals, h.deals);
+    ASSERT_EQUALS(p->ai, h.ai);
+    ASSERT_EQUALS(p->deal_preflop_calls + p->deal_preflop_bets + p->deal_preflop_raises, h.vpip);
+    ASSERT_EQUALS((long long)p->chips_won, h.chips_won);
+    ASSERT_EQUALS((long long)p->chips_lost, h.chips_lost);
+    ASSERT_EQUALS(p->flops_seen, h.flops);
+    ASSERT_EQUALS(p->showdowns_seen, h.showdowns);
+    int positionDeals = 0;
+    for(int j = 0; j < HR_MAX_SEATS; j++) positionDeals += h.deals_position[j];
+    ASSERT_EQUALS(h.deals, positionDeals);
+  }
+
+  HandRecordFilter filter;
+  filter.minPot = 100000000;
+  queryHandRecords(result, file, filter);
+  ASSERT_EQUALS(0, result[0].deals);
+
+  std::remove("unittest_hands.bin");
+
+  std::cout << std::endl;
+}
+
+void testStatKeeperIds()
+{
+  std::cout << "Testing StatKeeper player ids" << std::endl;
+
+  //two games in which the same ids are different players: the StatKeeper must keep them apart by name
+  EventStrings game1, game2;
+  game1.addPlayer("alice", "");
+  game1.addPlayer("bob", "");
+  game2.addPlayer("bob", "");
+  game2.addPlayer("carol", "");
+
+  StatKeeper keeper;
+  Event event(E_JOIN, 0, 100);
+  event.strings = &game1;
+  keeper.onEvent(event);
+  event.strings = &game2;
+  keeper.onEvent(event);
+  event = Event(E_REBUY, 1, 50);
+  event.strings = &game2;
+  keeper.onEvent(event);
+  event.strings = &game1;
+  keeper.onEvent(event);
+
+  ASSERT_EQUALS(100, keeper.getPlayerStats("alice")->chips_bought);
+  ASSERT_EQUALS(150, keeper.getPlayerStats("bob")->chips_bought);
+  ASSERT_EQUALS(50, keeper.getPlayerStats("carol")->chips_bought);
+
+  std::vector<std::string> players;
+  keeper.getAllPlayers(players);
+  ASSERT_EQUALS(3u, players.size());
+
+  std::cout << std::endl;
+}
+
+//one heads-up deal between player 0 and 1: player 0 raises and player 1 folds, or player 0 folds
+static void playRecentStatsDeal(StatKeeper& keeper, const EventStrings& strings, bool raise)
+{
+  std::vector<Event> events;
+  events.push_back(Event(E_NEW_DEAL, 5, 10, 0));
+  events.push_back(Event(E_SMALL_BLIND, 0, 5));
+  events.push_back(Event(E_BIG_BLIND, 1, 10));
+  if(raise)
+  {
+    events.push_back(Event(E_RAISE, 0, 20));
+    events.push_back(Event(E_FOLD, 1));
+    events.push_back(Event(E_POT_DIVISION, -1, 40));
+    events.push_back(Event(E_WIN, 0, 40));
+  }
+  else
+  {
+    events.push_back(Event(E_FOLD, 0));
+    events.push_back(Event(E_POT_DIVISION, -1, 15));
+    events.push_back(Event(E_WIN, 1, 15));
+  }
+  for(size_t i = 0; i < events.size(); i++)
+  {
+    events[i].strings = &strings;
+    keeper.onEvent(events[i]);
+  }
+}
+
+void testRecentStats()
+{
+  std::cout << "Testing recent stats" << std::endl;
+
+  EventStrings strings;
+  strings.addPlayer("a", "");
+  strings.addPlayer("b", "");
+
+  StatKeeper keeper;
+  keeper.setRecentStatsSettings(10, 0.5);
+  for(int i = 0; i < 2; i++)
+  {
+    Event event(E_JOIN, i, 1000);
+    event.strings = &strings;
+    keeper.onEvent(event);
+  }
+
+  //a raises a lot at first, then only folds: the recent stats must show that, the lifetime stats not
+  for(int i = 0; i < 20; i++) playRecentStatsDeal(keeper, strings, true);
+  ASSERT_EQUALS(10, keeper.getWindowStats("a")->deals); //the last deal isn't added until the next one starts
+  ASSERT_EQUALS(1.0, keeper.getWindowStats("a")->getPFR());
+  for(int i = 0; i < 10; i++) playRecentStatsDeal(keeper, strings, false);
+  playRecentStatsDeal(keeper, strings, false);
+
+  ASSERT_EQUALS(10, keeper.getWindowStats("a")->deals);
+  ASSERT_EQUALS(0.0, keeper.getWindowStats("a")->getPFR());
+  ASSERT_EQUALS(0.0, keeper.getWindowStats("a")->getVPIP());
+  ASSERT_TRUE(keeper.getPlayerStats("a")->getPFR() > 0.5);
+  ASSERT_TRUE(keeper.getDecayedStats("a")->getPFR() < 0.01);
+  ASSERT_TRUE(keeper.getDecayedStats("a")->deals < 2.0); //1 + 0.5 + 0.25 + ...
+  ASSERT_EQUALS(10 * 15, keeper.getWindowStats("b")->chips_won);
+  ASSERT_TRUE(keeper.getWindowStats("nobody") == 0);
+
+  std::cout << std::endl;
+}
+
+void testPositionStats()
+{
+  std::cout << "Testing statistics per position" << std::endl;
+
+  //one deal at a table of 6: everyone folds to the big blind
+  {
+    EventStrings strings;
+    const char* names[6] = { "p0", "p1", "p2", "p3", "p4", "p5" };
+    for(int i = 0; i < 6; i++) strings.addPlayer(names[i], "");
+    std::vector<Event> events;
+    for(int i = 0; i < 6; i++) events.push_back(Event(E_JOIN, i, 1000));
+    events.push_back(Event(E_NEW_DEAL, 5, 10, 0));
+    events.push_back(Event(E_DEALER, 0));
+    events.push_back(Event(E_SMALL_BLIND, 1, 5));
+    events.push_back(Event(E_BIG_BLIND, 2, 10));
+    events.push_back(Event(E_FOLD, 3));
+    events.push_back(Event(E_FOLD, 4));
+    events.push_back(Event(E_FOLD, 5));
+    events.push_back(Event(E_FOLD, 0));
+    events.push_back(Event(E_FOLD, 1));
+    events.push_back(Event(E_POT_DIVISION, -1, 15));
+    events.push_back(Event(E_WIN, 2, 15));
+    StatKeeper keeper;
+    for(size_t i = 0; i < events.size(); i++)
+    {
+      events[i].strings = &strings;
+      keeper.onEvent(events[i]);
+    }
+
+    int expected[6] = { POS_LATE, POS_SB, POS_BB, POS_EARLY, POS_MID, POS_LATE };
+    for(int i = 0; i < 6; i++)
+    {
+      const PlayerStats* stats = keeper.getPlayerStats(names[i]);
+      ASSERT_EQUALS(1, stats->positions[expected[i]].deals);
+      ASSERT_EQUALS(1, stats->table_sizes[6 - 2].deals);
+      ASSERT_EQUALS(i == 2 ? 0 : 1, stats->positions[expected[i]].folds);
+    }
+    ASSERT_EQUALS(1, keeper.getPlayerStats("p2")->positions[POS_BB].wins);
+  }
+
+  //with an ante: p3 goes all-in by the ante and never acts, the players after p3 keep their positions
+  {
+    EventStrings strings;
+    const char* names[6] = { "p0", "p1", "p2", "p3", "p4", "p5" };
+    for(int i = 0; i < 6; i++) strings.addPlayer(names[i], "");
+    std::vector<Event> events;
+    for(int i = 0; i < 6; i++) events.push_back(Event(E_JOIN, i, i == 3 ? 5 : 1000));
+    events.push_back(Event(E_NEW_DEAL, 5, 10, 10));
+    events.push_back(Event(E_DEALER, 0));
+    events.push_back(Event(E_SMALL_BLIND, 1, 5));
+    events.push_back(Event(E_BIG_BLIND, 2, 10));
+    for(int i = 0; i < 6; i++) events.push_back(Event(E_ANTE, i, i == 3 ? 5 : 10));
+    events.push_back(Event(E_FOLD, 4));
+    events.push_back(Event(E_FOLD, 5));
+    events.push_back(Event(E_FOLD, 0));
+    events.push_back(Event(E_FOLD, 1));
+    events.push_back(Event(E_CHECK, 2));
+    StatKeeper keeper;
+    for(size_t i = 0; i < events.size(); i++)
+    {
+      events[i].strings = &strings;
+      keeper.onEvent(events[i]);
+    }
+
+    int expected[6] = { POS_LATE, POS_SB, POS_BB, POS_EARLY, POS_MID, POS_LATE };
+    for(int i = 0; i < 6; i++)
+    {
+      const PlayerStats* stats = keeper.getPlayerStats(names[i]);
+      ASSERT_EQUALS(i == 2 || i == 3 ? 0 : 1, stats->positions[expected[i]].folds);
+    }
+    ASSERT_EQUALS(1, keeper.getPlayerStats("p3")->allins);
+    ASSERT_EQUALS(1, keeper.getPlayerStats("p3")->positions[POS_EARLY].allins);
+    ASSERT_EQUALS(0, keeper.getPlayerStats("p3")->positions[POS_EARLY].actions);
+    ASSERT_EQUALS(1, keeper.getPlayerStats("p4")->positions[POS_MID].folds);
+  }
+
+
+  //in a whole game, the counts of all positions, and of all table sizes, must add up to those of PlayerStats.
+  //With an ante, some players go all-in by the ante and never act.
+  for(int ante = 0; ante <= 40; ante += 40)
+  {
+    HostUnitTest host;
+    Game game(&host);
+    Rules rules;
+    rules.buyIn = 1000;
+    rules.smallBlind = 10;
+    rules.bigBlind = 20;
+    rules.ante = ante;
+    rules.allowRebuy = true;
+    rules.fixedNumberOfDeals = 1000;
+    game.setRules(rules);
+    game.setSeed(6);
+    game.addPlayer(Player(new AICall(), "call"));
+    game.addPlayer(Player(new AIRaise(), "raise"));
+    game.addPlayer(Player(new AIRandom(), "random"));
+    game.addPlayer(Player(new AIBlindLimp(), "blindlimp"));
+    game.addPlayer(Player(new AIRandom(), "random2"));
+    game.addPlayer(Player(new AICall(), "call2"));
+    ObserverStatKeeper* keeper = new ObserverStatKeeper();
+    game.addObserver(keeper);
+    game.doGame();
+
+    std::vector<std::string> players;
+    keeper->getStatKeeper().getAllPlayers(players);
+    for(size_t i = 0; i < players.size(); i++)
+    {
+      const PlayerStats* stats = keeper->getStatKeeper().getPlayerStats(players[i]);
+      ActionStats positions = ActionStats(), sizes = ActionStats(); //all zero
+      for(int j = 0; j < NUM_POSITIONS; j++) positions.add(stats->positions[j]);
+      for(int j = 0; j < NUM_TABLE_SIZES; j++) sizes.add(stats->table_sizes[j]);
+      ActionStats* sums[2] = { &positions, &sizes };
+      for(int j = 0; j < 2; j++)
+      {
+        ASSERT_EQUALS(stats->deals, sums[j]->deals);
+        ASSERT_EQUALS(stats->actions, sums[j]->actions);
+        ASSERT_EQUALS(stats->folds, sums[j]->folds);
+        ASSERT_EQUALS(stats->checks, sums[j]->checks);
+        ASSERT_EQUALS(stats->calls, sums[j]->calls);
+        ASSERT_EQUALS(stats->bets, sums[j]->bets);
+        ASSERT_EQUALS(stats->raises, sums[j]->raises);
+        ASSERT_EQUALS(stats->allins, sums[j]->allins);
+        ASSERT_EQUALS(stats->wins_total, sums[j]->wins);
+        ASSERT_EQUALS(stats->getVPIP(), sums[j]->getVPIP());
+      }
+      ASSERT_TRUE(stats->table_sizes[6 - 2].deals > 0);
+      for(int j = 0; j < NUM_POSITIONS; j++) ASSERT_TRUE(stats->positions[j].deals > 0);
+    }
+    //the AI that always raises is as aggressive from every position, except in the big blind when everyone folds to it
+    ASSERT_TRUE(keeper->getStatKeeper().getPlayerStats("raise")->positions[POS_EARLY].getPFR() > 0.9);
+    ASSERT_TRUE(keeper->getStatKeeper().getPlayerStats("raise")->positions[POS_LATE].getPFR() > 0.9);
+  }
+
+  std::cout << std::endl;
+}
+
+void testUpdateInfo()
+{
+  std::cout << "Testing updateInfo" << std::endl;
+
+  AICall ai;
+  Table table;
+  table.players.push_back(Player(&ai, "a"));
+  table.players.push_back(Player(&ai, "b"));
+  table.players.push_back(Player(&ai, "c"));
+  for(size_t i = 0; i < table.players.size(); i++) table.players[i].stack = 1000;
+  table.players[0].holeCard1 = Card("Ah"); table.players[0].holeCard2 = Card("Kh");
+  table.players[1].holeCard1 = Card("2c"); table.players[1].holeCard2 = Card("7d");
+  table.players[2].holeCard1 = Card("Qs"); table.players[2].holeCard2 = Card("Qd");
+  table.boardCard1 = Card("3h"); table.boardCard2 = Card("8h"); table.boardCard3 = Card("Jc");
+  table.boardCard4 = Card("4s"); table.boardCard5 = Card("9d");
+  table.round = R_FLOP;
+
+  Rules rules;
+  Info info;
+  makeInfo(info, table, rules, 0);
+  ASSERT_EQUALS(3u, info.boardCards.size());
+  ASSERT_EQUALS(2u, info.getHoleCards().size());
+
+  //change the table and view point, the updated info must be the same as a new one
+  table.round = R_RIVER;
+  table.current = 2;
+  table.players[1].folded = true;
+  table.players[2].stack = 800;
+  table.players[2].wager = 200;
+  table.players[0].showdown = true;
+  updateInfo(info, table, 2);
+
+  Info info2;
+  makeInfo(info2, table, rules, 2);
+  ASSERT_EQUALS(info2.boardCards.size(), info.boardCards.size());
+  for(size_t i = 0; i < info.boardCards.size(); i++) ASSERT_EQUALS(info2.boardCards[i].getIndex(), info.boardCards[i].getIndex());
+  ASSERT_EQUALS(info2.current, info.current);
+  ASSERT_EQUALS(info2.getCallAmount(), info.getCallAmount());
+  for(size_t i = 0; i < info.players.size(); i++)
+  {
+    ASSERT_EQUALS(info2.players[i].name, info.players[i].name);
+    ASSERT_EQUALS(info2.players[i].folded, info.players[i].folded);
+    ASSERT_EQUALS(info2.players[i].stack, info.players[i].stack);
+    ASSERT_EQUALS(info2.players[i].holeCards.size(), info.players[i].holeCards.size());
+  }
+  ASSERT_EQUALS(Card("Kh").getIndex(), info.players[0].holeCards[1].getIndex());
+  ASSERT_TRUE(info.players[1].holeCards.empty()); //the viewpoint moved away from player 0, but player 0 did show the cards
+  ASSERT_EQUALS(Card("Qs").getIndex(), info.getHoleCards()[0].getIndex());
+
+  std::cout << std::endl;
+}
+
+void testEvent()
+{
+  std::cout << "Testing event" << std::endl;
+
+  EventStrings strings;
+  ASSERT_EQUALS(0, strings.addPlayer("Alice", "Call"));
+  ASSERT_EQUALS(1, strings.addPlayer("Bob", "Raise"));
+
+  Event raise(E_RAISE, 1, 40);
+  ASSERT_EQUALS(std::string(""), raise.getPlayer()); //the game didn't give it its strings yet
+  raise.strings = &strings;
+  ASSERT_EQUALS(std::string("Bob"), raise.getPlayer());
+  ASSERT_EQUALS(std::string("Raises: Bob, chips: 40"), eventToString(raise));
+
+  Event reveal(E_REVEAL_AI, 0);
+  reveal.strings = &strings;
+  ASSERT_EQUALS(std::string("Call"), reveal.getAI());
+
+  Event flop(E_FLOP, Card("Ah"), Card("Kh"), Card("2c"));
+  flop.strings = &strings;
+  ASSERT_TRUE(!flop.hasPlayer());
+  ASSERT_EQUALS(std::string("Flop: Ah Kh 2c"), eventToString(flop));
+
+  Event message(E_LOG_MESSAGE);
+  message.messageId = strings.addMessage("hello");
+  message.strings = &strings;
+  ASSERT_EQUALS(std::string("hello"), eventToString(message));
+
+  std::cout << std::endl;
+}
+
+//counts the events it gets
+class AICountEvents : public AICall
+{
+  public:
+    int& count;
+    AICountEvents(int& count) : count(count) {}
+    virtual void onEvent(const Event& event) { (void)event; count++; }
+    virtual EventMask getEventMask() const { return EVENTMASK_ALL; }
+};
+
+class ObserverCountFlops : public Observer
+{
+  public:
+    int& count;
+    ObserverCountFlops(int& count) : count(count) {}
+    virtual void onEvent(const Event& event) { ASSERT_EQUALS(E_FLOP, event.type); count++; }
+    virtual EventMask getEventMask() const { return eventMask(E_FLOP); }
+};
+
+//plays random, and checks at each decision that its InfoKeeper has the same Info as the game
+class AIInfoKeeperCheck : public AIRandom
+{
+  public:
+    InfoKeeper keeper;
+    int& decisions;
+    AIInfoKeeperCheck(int& decisions, const Rules& rules) : keeper(rules), decisions(decisions) {}
+    virtual void onEvent(const Event& event) { keeper.onEvent(event); }
+    virtual EventMask getEventMask() const { return InfoKeeper::getEventMask(); }
+
+    virtual Action doTurn(const Info& info)
+    {
+      const Info& kept = keeper.getInfo();
+      ASSERT_EQUALS(info.yourIndex, kept.yourIndex);
+      ASSERT_EQUALS(info.dealer, kept.dealer);
+      ASSERT_EQUALS(info.current, kept.current);
+      ASSERT_EQUALS(info.round, kept.round);
+      ASSERT_EQUALS(info.turn, kept.turn);
+      ASSERT_EQUALS(info.minRaiseAmount, kept.minRaiseAmount);
+      ASSERT_EQUALS(info.rules.ante, kept.rules.ante);
+      ASSERT_EQUALS(info.boardCards.size(), kept.boardCards.size());
+      for(size_t i = 0; i < info.boardCards.size() && i < kept.boardCards.size(); i++) ASSERT_EQUALS(info.boardCards[i].getIndex(), kept.boardCards[i].getIndex());
+      ASSERT_EQUALS(info.players.size(), kept.players.size());
+      for(size_t i = 0; i < info.players.size() && i < kept.players.size(); i++)
+      {
+        const PlayerInfo& a = info.players[i];
+        const PlayerInfo& b = kept.players[i];
+        ASSERT_EQUALS(a.name, b.name);
+        ASSERT_EQUALS(a.stack, b.stack);
+        ASSERT_EQUALS(a.wager, b.wager);
+        ASSERT_EQUALS(a.folded, b.folded);
+        ASSERT_EQUALS(a.showdown, b.showdown);
+        ASSERT_EQUALS(a.holeCards.size(), b.holeCards.size());
+        for(size_t j = 0; j < a.holeCards.size() && j < b.holeCards.size(); j++) ASSERT_EQUALS(a.holeCards[j].getIndex(), b.holeCards[j].getIndex());
+        ASSERT_EQUALS(a.lastAction.command, b.lastAction.command);
+        if(a.lastAction.command == A_RAISE) ASSERT_EQUALS(a.lastAction.amount, b.lastAction.amount);
+      }
+      decisions++;
+      return AIRandom::doTurn(info);
+    }
+};
+
+void testInfoKeeper()
+{
+  std::cout << "Testing InfoKeeper" << std::endl;
+
+  Rules rules;
+  rules.buyIn = 1000;
+  rules.smallBlind = 10;
+  rules.bigBlind = 20;
+  rules.ante = 5;
+  rules.fixedNumberOfDeals = 1000;
+
+  int decisions = 0;
+  for(int rebuy = 0; rebuy < 2; rebuy++) //without rebuys, players quit too
+  {
+    rules.allowRebuy = rebuy != 0;
+    HostUnitTest host;
+    Game game(&host);
+    game.setRules(rules);
+    game.setSeed(31);
+    game.addPlayer(Player(new AIInfoKeeperCheck(decisions, rules), "check1"));
+    game.addPlayer(Player(new AICall(), "call"));
+    game.addPlayer(Player(new AIInfoKeeperCheck(decisions, rules), "check2"));
+    game.addPlayer(Player(new AIRaise(), "raise"));
+    game.addPlayer(Player(new AIInfoKeeperCheck(decisions, rules), "check3"));
+    game.doGame();
+  }
+  std::cout << "decisions: " << decisions << std::endl;
+  ASSERT_TRUE(decisions > 1000);
+
+  std::cout << std::endl;
+}
+
+void testEventDispatcher()
+{
+  std::cout << "Testing event dispatcher" << std::endl;
+
+  int aiCount = 0, observerCount = 0;
+  AICall call;
+  AICountEvents counter(aiCount);
+  ObserverCountFlops flops(observerCount);
+
+  std::vector<Player> players;
+  players.push_back(Player(&call, "call")); //AICall doesn't want events, so it isn't even called
+  players.push_back(Player(&counter, "counter"));
+  std::vector<Observer*> observers;
+  observers.push_back(&flops);
+
+  EventDispatcher dispatcher;
+  dispatcher.setup(players, observers);
+
+  std::vector<Event> events;
+  events.push_back(Event(E_NEW_DEAL, 10, 20, 0));
+  events.push_back(Event(E_CALL, 0));
+  events.push_back(Event(E_FLOP, Card("Ah"), Card("Kh"), Card("2c")));
+  events.push_back(Event(E_LOG_MESSAGE)); //not for AI's
+  size_t sent = 0;
+  dispatcher.send(sent, events);
+
+  ASSERT_EQUALS(4u, sent);
+  ASSERT_EQUALS(3, aiCount);
+  ASSERT_EQUALS(1, observerCount);
+
+  std::cout << std::endl;
+}
+
 void testCardPrint() {
   std::cout << "Testing card print" << std::endl;
   std::cout << Card(2, S_CLUBS).getShortNamePrintable() << std::endl;
@@ -557,6 +1938,10 @@ void doUnitTest()
   std::cout << "Performing Unit Test" << std::endl << std::endl;
 
   testRandom();
+  testChaCha20();
+  testRandomBounded();
+  testRandomLanes();
+  testDeck();
 
   int dummy[7] = {1,1,1,1,1,1,1};
   eval7(dummy); //show its initialization messages before the unit test starts...
@@ -566,9 +1951,33 @@ void doUnitTest()
 
   testWinChanceAtFlopAgainst9();
 
+  testEnumerateKSubsets();
+  testWinChanceWithKnownHands();
+  benchmarkWinChanceSampling();
+  benchmarkWinChanceBatched();
+  testEquityCache();
+
   testEval5();
 
   testDividePot();
+  testExpectedPotDivision();
+  testSeededGame();
+  testSeededCards();
+  testEvent();
+  testEventJournal();
+  testEventDispatcher();
+  testObserverAsync();
+  testCompress();
+  testObserverLog();
+  testEventParser();
+  testUpdateInfo();
+  testDuplicate();
+  testMultiTable();
+  testHandRecord();
+  testStatKeeperIds();
+  testRecentStats();
+  testPositionStats();
+  testInfoKeeper();
 
   testBetsSettled();
 